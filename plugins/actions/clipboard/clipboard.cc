@@ -564,11 +564,9 @@ class ClipboardPlugin : public Action {
     clear_clipdoc(doc);
 
     Subtitles clipsubs = clipdoc->subtitles();
-    unsigned long i = 0;
-    while (i < selection.size()) {
-      Subtitle sub = clipsubs.append();
+    Subtitle sub = clipsubs.append(selection.size());
+    for (unsigned long i = 0; i < selection.size(); ++i, ++sub) {
       selection[i].copy_to(sub);
-      i++;
     }
 
     // format for the plain-text clipboard target
@@ -722,20 +720,18 @@ class ClipboardPlugin : public Action {
                                          std::vector<Subtitle> &new_subtitles) {
     // We can reserve the size of the array new_subtitles because we already
     // know the number of new subtitles
-    new_subtitles.reserve(clipdoc->subtitles().size());
+    unsigned int size = clipdoc->subtitles().size();
+    new_subtitles.reserve(size);
 
-    Subtitle after = paste_after;
+    // All the subtitles are inserted at once
+    Subtitle new_sub = (paste_after) ? subtitles.insert_after(paste_after, size)
+                                     : subtitles.append(size);
 
     for (Subtitle clip_sub = clipdoc->subtitles().get_first(); clip_sub;
-         ++clip_sub) {
-      Subtitle new_sub =
-          (after) ? subtitles.insert_after(after) : subtitles.append();
-
+         ++clip_sub, ++new_sub) {
       clip_sub.copy_to(new_sub);
 
       new_subtitles.push_back(new_sub);
-
-      after = new_sub;
     }
   }
 
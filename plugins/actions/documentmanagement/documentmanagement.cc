@@ -24,7 +24,9 @@
 #include <player.h>
 #include <subtitleformatsystem.h>
 #include <utility.h>
+#include <memory>
 #include <vector>
+#include "recovery.h"
 
 class DialogAskToSaveOnExit : public Gtk::MessageDialog {
  public:
@@ -180,6 +182,10 @@ class DocumentManagementPlugin : public Action {
 
     init_autosave();
 
+    // The recovery files of a crash
+    Glib::signal_idle().connect(
+        sigc::mem_fun(*this, &DocumentManagementPlugin::on_check_recovery));
+
     ui_id = ui->new_merge_id();
 
 #define ADD_UI(name)                                                      \
@@ -225,6 +231,7 @@ class DocumentManagementPlugin : public Action {
 
     m_config_interface_connection.disconnect();
     m_autosave_timeout.disconnect();
+    m_recovery.reset();
   }
 
   void update_ui() {
@@ -658,10 +665,11 @@ class DocumentManagementPlugin : public Action {
     }
   }
 
-  // Only for "used-autosave" and "autosave-minutes".
+  // Only for "used-autosave", "autosave-minutes" and "autosave-to-recovery".
   void on_config_interface_changed(const Glib::ustring &key,
                                    const Glib::ustring & /*value*/) {
-    if (key == "used-autosave" || key == "autosave-minutes")
+    if (key == "used-autosave" || key == "autosave-minutes" ||
+        key == "autosave-to-recovery")
       init_autosave();
   }
 
@@ -669,12 +677,20 @@ class DocumentManagementPlugin : public Action {
     se_dbg(SE_DBG_PLUGINS);
 
     m_autosave_timeout.disconnect();
+    m_recovery.reset();
 
     if (cfg::get_boolean("interface", "used-autosave") == false)
       return;
 
     int autosave_minutes = cfg::get_int("interface", "autosave-minutes");
 
+    // The documents are saved in the recovery directory, not in the files
+    if (cfg::get_boolean("interface", "autosave-to-recovery")) {
+      m_recovery.reset(new Recovery(autosave_minutes));
+      se_dbg_msg(SE_DBG_PLUGINS, "recovery every %d minutes", autosave_minutes);
+      return;
+    }
+
     long mseconds = SubtitleTime(0, autosave_minutes, 0, 0).totalmsecs;
 
     m_autosave_timeout = Glib::signal_timeout().connect(
@@ -692,11 +708,17 @@ class DocumentManagementPlugin : public Action {
     return true;
   }
 
+  bool on_check_recovery() {
+    Recovery::recover();
+    return false;
+  }
+
  protected:
   Gtk::UIManager::ui_merge_id ui_id;
   Glib::RefPtr<Gtk::ActionGroup> action_group;
   sigc::connection m_config_interface_connection;
   sigc::connection m_autosave_timeout;
+  std::unique_ptr<Recovery> m_recovery;
 };
 
 REGISTER_EXTENSION(DocumentManagementPlugin)
@@ -0,0 +1,573 @@
+#pragma once
+
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://kitone.github.io/subtitleeditor/
+// https://github.com/kitone/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include <documents.h>
+#include <glib/gstdio.h>
+#include <subtitleformatsystem.h>
+#include <utility.h>
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#ifdef G_OS_UNIX
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+// Write the recovery files from a worker thread, in the order of the
+// requests. The pending requests are written before the destruction.
+class RecoveryWriter {
+ public:
+  RecoveryWriter() : m_stop(false) {
+    m_thread = Glib::Threads::Thread::create(
+        sigc::mem_fun(*this, &RecoveryWriter::run));
+  }
+
+  ~RecoveryWriter() {
+    {
+      Glib::Threads::Mutex::Lock lock(m_mutex);
+      m_stop = true;
+      m_cond.signal();
+    }
+    m_thread->join();
+  }
+
+  // Replace the file, the data is written in a temporary file then renamed.
+  void write(const std::string &path, const std::string &data) {
+    push(WRITE, path, data);
+  }
+
+  // Append the data at the end of the file.
+  void append(const std::string &path, const std::string &data) {
+    push(APPEND, path, data);
+  }
+
+  void remove(const std::string &path) {
+    push(REMOVE, path, std::string());
+  }
+
+ protected:
+  enum Type { WRITE, APPEND, REMOVE };
+
+  struct Job {
+    Type type;
+    std::string path;
+    std::string data;
+  };
+
+  void push(Type type, const std::string &path, const std::string &data) {
+    Glib::Threads::Mutex::Lock lock(m_mutex);
+    m_jobs.push_back(Job{type, path, data});
+    m_cond.signal();
+  }
+
+  void run() {
+    for (;;) {
+      Job job;
+      {
+        Glib::Threads::Mutex::Lock lock(m_mutex);
+        while (m_jobs.empty() && !m_stop) m_cond.wait(m_mutex);
+        if (m_jobs.empty())
+          return;
+        job = m_jobs.front();
+        m_jobs.pop_front();
+      }
+      execute(job);
+    }
+  }
+
+  void execute(const Job &job) {
+    try {
+      if (job.type == WRITE) {
+        // g_file_set_contents write a temporary file and rename it
+        Glib::file_set_contents(job.path, job.data);
+      } else if (job.type == APPEND) {
+        FILE *file = g_fopen(job.path.c_str(), "ab");
+        if (file == NULL)
+          return;
+        fwrite(job.data.data(), 1, job.data.size(), file);
+        fflush(file);
+        fclose(file);
+      } else if (job.type == REMOVE) {
+        g_remove(job.path.c_str());
+      }
+    } catch (const Glib::Error &ex) {
+      std::cerr << "RecoveryWriter: " << ex.what() << std::endl;
+    }
+  }
+
+ protected:
+  Glib::Threads::Thread *m_thread;
+  Glib::Threads::Mutex m_mutex;
+  Glib::Threads::Cond m_cond;
+  std::deque<Job> m_jobs;
+  bool m_stop;
+};
+
+// Autosave the changed documents in a recovery directory instead of
+// overwriting the files of the user.
+//
+// Every 'snapshot_minutes' the changed documents are serialized (Subtitle
+// Editor Project format) in the main loop, then written by the worker.
+// Between the snapshots, the inserted and removed rows and the values of the
+// changed subtitles are appended every kJournalInterval seconds to a
+// journal. Only a reorder (or the first change) asks for a new snapshot.
+//
+// The files of a document are removed when it's saved or closed, and all of
+// them when the Recovery is destroyed. The files left at the start are from
+// a crash, Recovery::recover offers to open them.
+class Recovery : public sigc::trackable {
+ public:
+  static const guint kJournalInterval = 5;
+
+  explicit Recovery(int snapshot_minutes)
+      : m_session(g_get_real_time()), m_next_id(0) {
+    se_dbg(SE_DBG_PLUGINS);
+
+    g_mkdir_with_parents(get_recovery_dir().c_str(), 0700);
+
+    for (const auto &doc : se::documents::all()) {
+      on_document_created(doc);
+    }
+
+    se::documents::signal_created().connect(
+        sigc::mem_fun(*this, &Recovery::on_document_created));
+    se::documents::signal_deleted().connect(
+        sigc::mem_fun(*this, &Recovery::on_document_deleted));
+
+    m_journal_timeout = Glib::signal_timeout().connect_seconds(
+        sigc::mem_fun(*this, &Recovery::on_journal_timeout),
+        kJournalInterval);
+    m_snapshot_timeout = Glib::signal_timeout().connect_seconds(
+        sigc::mem_fun(*this, &Recovery::on_snapshot_timeout),
+        std::max(1, snapshot_minutes) * 60);
+  }
+
+  // It's not a crash (quit, autosave disabled or changed), the files are
+  // removed. A new Recovery writes its own files.
+  ~Recovery() {
+    m_journal_timeout.disconnect();
+    m_snapshot_timeout.disconnect();
+
+    for (auto &e : m_entries) {
+      disconnect(e.second);
+      remove_files(e.second);
+    }
+  }
+
+  static Glib::ustring get_recovery_dir() {
+    return utility::get_config_dir("recovery");
+  }
+
+  // Offer to open the documents left by a previous session. The recovery
+  // files are removed after.
+  static void recover() {
+    se_dbg(SE_DBG_PLUGINS);
+
+    Glib::ustring dirname = get_recovery_dir();
+    if (!Glib::file_test(dirname, Glib::FILE_TEST_IS_DIR))
+      return;
+
+    std::vector<std::string> infos;
+    Glib::ustring names;
+    try {
+      Glib::Dir dir(dirname);
+      for (const auto &name : dir) {
+        if (!Glib::str_has_suffix(name, ".info"))
+          continue;
+
+        std::string path = Glib::build_filename(dirname, name);
+        Glib::KeyFile key;
+        key.load_from_file(path);
+        if (is_running(key.get_integer("recovery", "pid")))
+          continue;
+
+        infos.push_back(path);
+        names += "\n" + key.get_string("recovery", "name");
+      }
+    } catch (const Glib::Error &ex) {
+      std::cerr << "recover: " << ex.what() << std::endl;
+    }
+
+    if (infos.empty())
+      return;
+
+    Gtk::MessageDialog dialog(
+        _("Recover the documents not saved before the crash?"), false,
+        Gtk::MESSAGE_QUESTION, Gtk::BUTTONS_YES_NO);
+    utility::set_transient_parent(dialog);
+    dialog.set_secondary_text(names);
+    bool restore = (dialog.run() == Gtk::RESPONSE_YES);
+    dialog.hide();
+
+    for (const auto &info : infos) {
+      std::string base = info.substr(0, info.size() - 5);
+      if (restore)
+        recover_document(info, base + ".sep", base + ".journal");
+      g_remove((base + ".sep").c_str());
+      g_remove((base + ".journal").c_str());
+      g_remove(info.c_str());
+    }
+  }
+
+ protected:
+  struct Entry {
+    std::string base;
+    // Rows changed since the last journal
+    std::set<unsigned int> rows;
+    // Rows inserted or removed since the last journal, in order
+    std::string structure;
+    // A snapshot is needed now (structure changed or no snapshot yet)
+    bool structure_changed;
+    bool has_snapshot;
+    // Changes since the last snapshot
+    bool changed;
+    std::vector<sigc::connection> connections;
+  };
+
+  static bool is_running(int pid) {
+#ifdef G_OS_UNIX
+    return pid == getpid() || kill(pid, 0) == 0;
+#else
+    return false;
+#endif
+  }
+
+  void on_document_created(Document *doc) {
+    Entry &e = m_entries[doc];
+    // The session avoid to reuse the files of a previous Recovery
+    e.base = Glib::build_filename(
+        get_recovery_dir(),
+        Glib::ustring::compose("%1-%2-%3", get_pid(), m_session, m_next_id++));
+    e.has_snapshot = false;
+    e.structure_changed = doc->get_document_changed();
+    e.changed = e.structure_changed;
+
+    Subtitles subtitles = doc->subtitles();
+    e.connections.push_back(subtitles.signal_inserted().connect(sigc::bind(
+        sigc::mem_fun(*this, &Recovery::on_row_inserted), doc)));
+    e.connections.push_back(subtitles.signal_deleted().connect(sigc::bind(
+        sigc::mem_fun(*this, &Recovery::on_row_deleted), doc)));
+    e.connections.push_back(subtitles.signal_reordered().connect(
+        sigc::bind(sigc::mem_fun(*this, &Recovery::on_structure), doc)));
+    e.connections.push_back(subtitles.signal_changed().connect(sigc::bind(
+        sigc::mem_fun(*this, &Recovery::on_row_changed), doc)));
+    e.connections.push_back(doc->get_signal("document-changed")
+                                .connect(sigc::bind(
+                                    sigc::mem_fun(*this, &Recovery::on_changed),
+                                    doc)));
+  }
+
+  void on_document_deleted(Document *doc) {
+    auto it = m_entries.find(doc);
+    if (it == m_entries.end())
+      return;
+    disconnect(it->second);
+    remove_files(it->second);
+    m_entries.erase(it);
+  }
+
+  void on_structure(Document *doc) {
+    Entry &e = m_entries[doc];
+    e.structure_changed = true;
+    e.changed = true;
+    e.structure.clear();
+  }
+
+  // The insert is journaled, the following changed rows are shifted.
+  void on_row_inserted(unsigned int row, Document *doc) {
+    Entry &e = m_entries[doc];
+    e.changed = true;
+    if (e.structure_changed || !e.has_snapshot)
+      return;
+
+    std::set<unsigned int> rows;
+    for (const auto &r : e.rows) {
+      rows.insert(r >= row ? r + 1 : r);
+    }
+    rows.insert(row);
+    e.rows.swap(rows);
+    e.structure += journal_structure('+', row);
+  }
+
+  void on_row_deleted(unsigned int row, Document *doc) {
+    Entry &e = m_entries[doc];
+    e.changed = true;
+    if (e.structure_changed || !e.has_snapshot)
+      return;
+
+    std::set<unsigned int> rows;
+    for (const auto &r : e.rows) {
+      if (r != row)
+        rows.insert(r > row ? r - 1 : r);
+    }
+    e.rows.swap(rows);
+    e.structure += journal_structure('-', row);
+  }
+
+  void on_row_changed(unsigned int row, Document *doc) {
+    Entry &e = m_entries[doc];
+    e.rows.insert(row);
+    e.changed = true;
+  }
+
+  // The document has been saved, the recovery files are useless.
+  void on_changed(Document *doc) {
+    if (doc->get_document_changed())
+      return;
+
+    Entry &e = m_entries[doc];
+    remove_files(e);
+    e.rows.clear();
+    e.structure.clear();
+    e.structure_changed = false;
+    e.changed = false;
+  }
+
+  // Append the inserted and removed rows then the changed subtitles to the
+  // journal, or write a snapshot if the rows have been reordered.
+  bool on_journal_timeout() {
+    for (auto &it : m_entries) {
+      Document *doc = it.first;
+      Entry &e = it.second;
+
+      if (!doc->get_document_changed())
+        continue;
+
+      if (e.structure_changed || !e.has_snapshot) {
+        snapshot(doc, e);
+        continue;
+      }
+      if (e.rows.empty() && e.structure.empty())
+        continue;
+
+      // The values are read now, after all the structure changes
+      std::string data;
+      data.swap(e.structure);
+      for (const auto &row : e.rows) {
+        Subtitle sub(doc, to_string(row));
+        if (sub)
+          data += journal_record(row, sub);
+      }
+      e.rows.clear();
+      m_writer.append(e.base + ".journal", data);
+    }
+    return true;
+  }
+
+  bool on_snapshot_timeout() {
+    for (auto &it : m_entries) {
+      if (it.second.changed && it.first->get_document_changed())
+        snapshot(it.first, it.second);
+    }
+    return true;
+  }
+
+  // Serialize the document in the main loop, the files are written by the
+  // worker. The journal is replaced by the snapshot.
+  void snapshot(Document *doc, Entry &e) {
+    se_dbg_msg(SE_DBG_PLUGINS, "snapshot %s", doc->getName().c_str());
+
+    Glib::ustring data;
+    try {
+      SubtitleFormatSystem::instance().write_to_data(
+          doc, data, "Subtitle Editor Project");
+    } catch (const std::exception &ex) {
+      std::cerr << "Recovery: " << ex.what() << std::endl;
+      return;
+    }
+
+    Glib::KeyFile info;
+    info.set_string("recovery", "name", doc->getName());
+    info.set_string("recovery", "filename", doc->getFilename());
+    info.set_string("recovery", "format", doc->getFormat());
+    info.set_string("recovery", "charset", doc->getCharset());
+    info.set_string("recovery", "newline", doc->getNewLine());
+    info.set_integer("recovery", "pid", get_pid());
+
+    // The old journal must never be replayed over the new snapshot, it's
+    // removed (with the info) before the snapshot is written. The info is
+    // written last, the files are complete when it exists.
+    m_writer.remove(e.base + ".info");
+    m_writer.remove(e.base + ".journal");
+    m_writer.write(e.base + ".sep", data.raw());
+    m_writer.write(e.base + ".info", info.to_data());
+
+    e.rows.clear();
+    e.structure.clear();
+    e.structure_changed = false;
+    e.has_snapshot = true;
+    e.changed = false;
+  }
+
+  void remove_files(Entry &e) {
+    if (!e.has_snapshot)
+      return;
+    m_writer.remove(e.base + ".info");
+    m_writer.remove(e.base + ".sep");
+    m_writer.remove(e.base + ".journal");
+    e.has_snapshot = false;
+  }
+
+  void disconnect(Entry &e) {
+    for (auto &connection : e.connections) {
+      connection.disconnect();
+    }
+    e.connections.clear();
+  }
+
+  static int get_pid() {
+#ifdef G_OS_UNIX
+    return getpid();
+#else
+    return 0;
+#endif
+  }
+
+  // A record is "<size>\n" followed by "row\0key\0value\0...", or by
+  // "+row\0" (insert) or "-row\0" (remove). A record truncated by a crash is
+  // ignored.
+  static std::string journal_structure(char type, unsigned int row) {
+    std::string payload = type + to_string(row);
+    payload.push_back('\0');
+    return to_string(payload.size()) + "\n" + payload;
+  }
+
+  static std::string journal_record(unsigned int row, Subtitle &sub) {
+    std::map<Glib::ustring, Glib::ustring> values;
+    sub.get(values);
+    values.erase("path");
+
+    std::string payload = to_string(row);
+    payload.push_back('\0');
+    for (const auto &v : values) {
+      payload += v.first.raw();
+      payload.push_back('\0');
+      payload += v.second.raw();
+      payload.push_back('\0');
+    }
+    return to_string(payload.size()) + "\n" + payload;
+  }
+
+  // Open the snapshot and replay the journal.
+  static void recover_document(const std::string &info_path,
+                               const std::string &sep_path,
+                               const std::string &journal_path) {
+    se_dbg_msg(SE_DBG_PLUGINS, "recover %s", sep_path.c_str());
+
+    Glib::KeyFile info;
+    try {
+      info.load_from_file(info_path);
+    } catch (const Glib::Error &ex) {
+      std::cerr << "recover: " << ex.what() << std::endl;
+      return;
+    }
+
+    Document *doc =
+        Document::create_from_file(Glib::filename_to_uri(sep_path), "UTF-8");
+    if (doc == NULL)
+      return;
+
+    std::string journal;
+    try {
+      if (Glib::file_test(journal_path, Glib::FILE_TEST_EXISTS))
+        journal = Glib::file_get_contents(journal_path);
+    } catch (const Glib::Error &ex) {
+      std::cerr << "recover: " << ex.what() << std::endl;
+    }
+
+    std::string::size_type pos = 0;
+    while (pos < journal.size()) {
+      std::string::size_type eol = journal.find('\n', pos);
+      if (eol == std::string::npos)
+        break;
+      std::string::size_type size =
+          utility::string_to_int(journal.substr(pos, eol - pos));
+      if (eol + 1 + size > journal.size())
+        break;
+      replay_record(doc, journal.substr(eol + 1, size));
+      pos = eol + 1 + size;
+    }
+
+    doc->setName(info.get_string("recovery", "name"));
+    doc->setFilename(info.get_string("recovery", "filename"));
+    doc->setFormat(info.get_string("recovery", "format"));
+    doc->setCharset(info.get_string("recovery", "charset"));
+    doc->setNewLine(info.get_string("recovery", "newline"));
+    doc->make_document_changed();
+    doc->emit_signal("document-property-changed");
+
+    se::documents::append(doc);
+  }
+
+  static void replay_record(Document *doc, const std::string &payload) {
+    std::vector<std::string> fields;
+    std::string::size_type pos = 0;
+    while (pos < payload.size()) {
+      std::string::size_type end = payload.find('\0', pos);
+      if (end == std::string::npos)
+        end = payload.size();
+      fields.push_back(payload.substr(pos, end - pos));
+      pos = end + 1;
+    }
+    if (fields.empty() || fields[0].empty())
+      return;
+
+    const std::string &first = fields[0];
+    if (first[0] == '+' || first[0] == '-') {
+      Subtitles subtitles = doc->subtitles();
+      Subtitle sub =
+          subtitles.get(utility::string_to_int(first.substr(1)) + 1);
+      if (first[0] == '-') {
+        if (sub)
+          subtitles.remove(sub);
+      } else if (sub) {
+        subtitles.insert_before(sub);
+      } else {
+        subtitles.append();
+      }
+      return;
+    }
+
+    Subtitle sub(doc, fields[0]);
+    if (!sub)
+      return;
+
+    std::map<Glib::ustring, Glib::ustring> values;
+    for (unsigned int i = 1; i + 1 < fields.size(); i += 2) {
+      values[fields[i]] = fields[i + 1];
+    }
+    sub.set(values);
+  }
+
+ protected:
+  std::map<Document *, Entry> m_entries;
+  gint64 m_session;
+  unsigned int m_next_id;
+  RecoveryWriter m_writer;
+  sigc::connection m_journal_timeout;
+  sigc::connection m_snapshot_timeout;
+};
@@ -25,6 +25,34 @@
 
 class ErrorChecking {
  public:
+  // A copy of the values of a subtitle used by the detection.
+  // A snapshot of the document can be checked from any thread.
+  class Data {
+   public:
+    Data() : num(0), characters_per_second_text(0) {
+    }
+
+    explicit Data(const Subtitle &sub)
+        : num(sub.get_num()),
+          start(sub.get_start()),
+          end(sub.get_end()),
+          text(sub.get_text()),
+          characters_per_line_text(sub.get_characters_per_line_text()),
+          characters_per_second_text(sub.get_characters_per_second_text()) {
+    }
+
+    SubtitleTime get_duration() const {
+      return end - start;
+    }
+
+    unsigned int num;
+    SubtitleTime start;
+    SubtitleTime end;
+    Glib::ustring text;
+    Glib::ustring characters_per_line_text;
+    double characters_per_second_text;
+  };
+
   class Info {
    public:
     Document *document;
@@ -85,10 +113,43 @@ class ErrorChecking {
     // init from your preferences values
   }
 
-  virtual bool execute(Info &) {
+  // Detect the error from the values of the subtitles.
+  // previous and next can be NULL. This function can be called from a worker
+  // thread, it must only read the values and the settings (init).
+  virtual bool detect(const Data * /*previous*/, const Data & /*current*/,
+                      const Data * /*next*/, Glib::ustring & /*error*/,
+                      Glib::ustring & /*solution*/) const {
     return false;
   }
 
+  // Fix the error of the subtitle, only called when an error is detected.
+  virtual bool fix(Info &) {
+    return false;
+  }
+
+  // Detect the error of the subtitle and try to fix it if info.tryToFix is
+  // true, otherwise info.error and info.solution are set.
+  bool execute(Info &info) {
+    Data current(info.currentSub);
+    Data previous, next;
+    if (info.previousSub)
+      previous = Data(info.previousSub);
+    if (info.nextSub)
+      next = Data(info.nextSub);
+
+    Glib::ustring error, solution;
+    if (!detect(info.previousSub ? &previous : nullptr, current,
+                info.nextSub ? &next : nullptr, error, solution))
+      return false;
+
+    if (info.tryToFix)
+      return fix(info);
+
+    info.error = error;
+    info.solution = solution;
+    return true;
+  }
+
  protected:
   Glib::ustring m_name;
   Glib::ustring m_label;
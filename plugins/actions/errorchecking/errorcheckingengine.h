@@ -0,0 +1,268 @@
+#pragma once
+
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://kitone.github.io/subtitleeditor/
+// https://github.com/kitone/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include <glibmm.h>
+#include <debug.h>
+#include <utility.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include "errorchecking.h"
+
+// Run the detection of the checkers over a snapshot of the document.
+//
+// The snapshot (ErrorChecking::Data) is copied from the document in the main
+// loop, then split in contiguous shards checked by worker threads. Each
+// subtitle has its own list of errors, so the results are in the document
+// order without any merge. signal_finished is emitted from the main loop
+// when all the shards are done. A running check can be canceled.
+//
+// After an edit, recheck() only revisits the edited subtitles and their
+// neighbours, insert() and erase() follow the structural changes.
+class ErrorCheckingEngine : public sigc::trackable {
+ public:
+  class Error {
+   public:
+    ErrorChecking *checker;
+    Glib::ustring error;
+    Glib::ustring solution;
+  };
+
+  // Minimum number of subtitles by worker.
+  static const unsigned int kMinShardSize = 256;
+
+  ErrorCheckingEngine() : m_cancel(false), m_finished_shards(0) {
+    m_dispatcher.connect(
+        sigc::mem_fun(*this, &ErrorCheckingEngine::on_shard_finished));
+  }
+
+  ~ErrorCheckingEngine() {
+    cancel();
+  }
+
+  // Start the detection of the checkers over the whole document.
+  // A running check is canceled. The checkers must not be modified (init)
+  // until the end of the check.
+  void check(Document *doc, const std::vector<ErrorChecking *> &checkers) {
+    se_dbg(SE_DBG_PLUGINS);
+
+    cancel();
+
+    m_checkers = checkers;
+    m_snapshot.clear();
+    m_errors.clear();
+
+    // The static values of the text utility are initialized here and not
+    // from a worker
+    utility::get_stripped_text(Glib::ustring());
+
+    Subtitles subtitles = doc->subtitles();
+    m_snapshot.reserve(subtitles.size());
+    for (Subtitle sub = subtitles.get_first(); sub; ++sub) {
+      m_snapshot.push_back(ErrorChecking::Data(sub));
+    }
+    m_errors.resize(m_snapshot.size());
+
+    unsigned int size = m_snapshot.size();
+    unsigned int n_shards = std::max(
+        1u, std::min<unsigned int>(g_get_num_processors(),
+                                   size / kMinShardSize));
+    unsigned int shard_size = (size + n_shards - 1) / n_shards;
+
+    se_dbg_msg(SE_DBG_PLUGINS, "subtitles=%d shards=%d", size, n_shards);
+
+    m_cancel = false;
+    m_finished_shards = 0;
+    for (unsigned int i = 0; i < n_shards; ++i) {
+      unsigned int first = i * shard_size;
+      unsigned int last = std::min(size, first + shard_size);
+      m_threads.push_back(Glib::Threads::Thread::create(
+          sigc::bind(sigc::mem_fun(*this, &ErrorCheckingEngine::run_shard),
+                     first, last)));
+    }
+  }
+
+  // Cancel the running check and wait for the workers.
+  // The results are incomplete.
+  void cancel() {
+    if (m_threads.empty())
+      return;
+
+    se_dbg(SE_DBG_PLUGINS);
+
+    m_cancel = true;
+    join();
+    m_snapshot.clear();
+    m_errors.clear();
+  }
+
+  // Remove the results.
+  void clear() {
+    cancel();
+    m_snapshot.clear();
+    m_errors.clear();
+  }
+
+  bool is_running() const {
+    return !m_threads.empty();
+  }
+
+  // Check again the subtitles [first, last] (index in the document) after an
+  // edit, with their neighbours. It's synchronous and only the values of the
+  // edited subtitles are read again.
+  // Return false if the results can't be updated (check running or the
+  // number of subtitles has changed), a full check is needed.
+  bool recheck(Document *doc, unsigned int first, unsigned int last) {
+    unsigned int size = m_snapshot.size();
+    if (is_running() || size == 0 || size != doc->subtitles().size())
+      return false;
+
+    last = std::min(last, size - 1);
+    if (first > last)
+      return true;
+
+    for (unsigned int i = first; i <= last; ++i) {
+      Subtitle sub = doc->subtitles().get(i + 1);
+      if (!sub)
+        return false;
+      m_snapshot[i] = ErrorChecking::Data(sub);
+    }
+
+    // The previous and the next subtitles depend on the edited values
+    unsigned int from = (first > 0) ? first - 1 : 0;
+    unsigned int to = std::min(last + 1, size - 1);
+    for (unsigned int i = from; i <= to; ++i) {
+      m_errors[i].clear();
+      check_subtitle(i);
+    }
+    return true;
+  }
+
+  // A subtitle has been inserted at the index (or removed), the following
+  // results are shifted. The neighbours must be checked again with recheck.
+  // Return false if the results can't be updated, a full check is needed.
+  bool insert(unsigned int index) {
+    if (is_running() || index > m_snapshot.size())
+      return false;
+    m_snapshot.insert(m_snapshot.begin() + index, ErrorChecking::Data());
+    m_errors.insert(m_errors.begin() + index, std::vector<Error>());
+    return true;
+  }
+
+  bool erase(unsigned int index) {
+    if (is_running() || index >= m_snapshot.size())
+      return false;
+    m_snapshot.erase(m_snapshot.begin() + index);
+    m_errors.erase(m_errors.begin() + index);
+    return true;
+  }
+
+  // Return the number of subtitles checked.
+  unsigned int size() const {
+    return m_errors.size();
+  }
+
+  // Return the number of the subtitle, the results follow the document
+  // order.
+  unsigned int get_num(unsigned int index) const {
+    return index + 1;
+  }
+
+  // Return the errors of the subtitle.
+  const std::vector<Error> &get_errors(unsigned int index) const {
+    return m_errors[index];
+  }
+
+  // Return the number of errors.
+  unsigned int get_error_count() const {
+    unsigned int count = 0;
+    for (const auto &errors : m_errors) {
+      count += errors.size();
+    }
+    return count;
+  }
+
+  // The check is done.
+  sigc::signal<void> &signal_finished() {
+    return m_signal_finished;
+  }
+
+ protected:
+  // Worker, check the subtitles [first, last).
+  void run_shard(unsigned int first, unsigned int last) {
+    for (unsigned int i = first; i < last && !m_cancel; ++i) {
+      check_subtitle(i);
+    }
+    ++m_finished_shards;
+    m_dispatcher.emit();
+  }
+
+  // Run all the checkers on the subtitle. Each subtitle has its own list of
+  // errors, the workers never write in the same memory.
+  void check_subtitle(unsigned int index) {
+    const ErrorChecking::Data *previous =
+        (index > 0) ? &m_snapshot[index - 1] : nullptr;
+    const ErrorChecking::Data *next =
+        (index + 1 < m_snapshot.size()) ? &m_snapshot[index + 1] : nullptr;
+
+    for (const auto &checker : m_checkers) {
+      Error e;
+      if (checker->detect(previous, m_snapshot[index], next, e.error,
+                          e.solution)) {
+        e.checker = checker;
+        m_errors[index].push_back(e);
+      }
+    }
+  }
+
+  // Main loop, called when a worker is done.
+  void on_shard_finished() {
+    // Canceled or already done
+    if (m_threads.empty() || m_finished_shards < m_threads.size())
+      return;
+
+    join();
+
+    se_dbg_msg(SE_DBG_PLUGINS, "errors=%d", get_error_count());
+
+    m_signal_finished.emit();
+  }
+
+  void join() {
+    for (auto &thread : m_threads) {
+      thread->join();
+    }
+    m_threads.clear();
+  }
+
+ protected:
+  std::vector<ErrorChecking *> m_checkers;
+  std::vector<ErrorChecking::Data> m_snapshot;
+  std::vector<std::vector<Error> > m_errors;
+
+  std::vector<Glib::Threads::Thread *> m_threads;
+  std::atomic<bool> m_cancel;
+  std::atomic<unsigned int> m_finished_shards;
+  Glib::Dispatcher m_dispatcher;
+
+  sigc::signal<void> m_signal_finished;
+};
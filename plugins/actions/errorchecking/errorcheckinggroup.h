@@ -0,0 +1,66 @@
+#pragma once
+
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://kitone.github.io/subtitleeditor/
+// https://github.com/kitone/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "errorchecking.h"
+#include "maxcharactersperline.h"
+#include "maxcharacterspersecond.h"
+#include "maxlinepersubtitle.h"
+#include "mincharacterspersecond.h"
+#include "mindisplaytime.h"
+#include "mingapbetweensubtitles.h"
+#include "overlapping.h"
+
+class ErrorCheckingGroup : public std::vector<ErrorChecking *> {
+ public:
+  ErrorCheckingGroup() {
+    push_back(new Overlapping);
+    push_back(new MinGapBetweenSubtitles);
+    push_back(new MaxCharactersPerSecond);
+    push_back(new MinCharactersPerSecond);
+    push_back(new MinDisplayTime);
+    push_back(new MaxCharactersPerLine);
+    push_back(new MaxLinePerSubtitle);
+
+    init_settings();
+  }
+
+  ~ErrorCheckingGroup() {
+    for (auto it = begin(); it != end(); ++it) {
+      delete *it;
+    }
+    clear();
+  }
+
+  void init_settings() {
+    for (auto it = begin(); it != end(); ++it) {
+      (*it)->init();
+    }
+  }
+
+  ErrorChecking *get_by_name(const Glib::ustring &name) {
+    for (auto it = begin(); it != end(); ++it) {
+      if ((*it)->get_name() == name)
+        return *it;
+    }
+    return nullptr;
+  }
+};
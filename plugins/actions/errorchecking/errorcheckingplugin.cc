@@ -22,52 +22,13 @@
 #include <gtkmm_utility.h>
 #include <utility.h>
 #include <memory>
+#include <set>
 
 #include "errorchecking.h"
+#include "errorcheckingengine.h"
+#include "errorcheckinggroup.h"
 #include "errorcheckingpreferences.h"
-#include "maxcharactersperline.h"
-#include "maxcharacterspersecond.h"
-#include "maxlinepersubtitle.h"
-#include "mincharacterspersecond.h"
-#include "mindisplaytime.h"
-#include "mingapbetweensubtitles.h"
-#include "overlapping.h"
-
-class ErrorCheckingGroup : public std::vector<ErrorChecking *> {
- public:
-  ErrorCheckingGroup() {
-    push_back(new Overlapping);
-    push_back(new MinGapBetweenSubtitles);
-    push_back(new MaxCharactersPerSecond);
-    push_back(new MinCharactersPerSecond);
-    push_back(new MinDisplayTime);
-    push_back(new MaxCharactersPerLine);
-    push_back(new MaxLinePerSubtitle);
-
-    init_settings();
-  }
-
-  ~ErrorCheckingGroup() {
-    for (auto it = begin(); it != end(); ++it) {
-      delete *it;
-    }
-    clear();
-  }
-
-  void init_settings() {
-    for (auto it = begin(); it != end(); ++it) {
-      (*it)->init();
-    }
-  }
-
-  ErrorChecking *get_by_name(const Glib::ustring &name) {
-    for (auto it = begin(); it != end(); ++it) {
-      if ((*it)->get_name() == name)
-        return *it;
-    }
-    return nullptr;
-  }
-};
+#include "liveerrorchecking.h"
 
 class DialogErrorChecking : public Gtk::Dialog {
   enum SortType { BY_CATEGORIES = 0, BY_SUBTITLES = 1 };
@@ -123,6 +84,11 @@ class DialogErrorChecking : public Gtk::Dialog {
     builder->get_widget("statusbar", m_statusbar);
 
     create_treeview();
+
+    m_engine.signal_finished().connect(
+        sigc::mem_fun(*this, &DialogErrorChecking::on_check_finished));
+
+    set_document(get_document());
     refresh();
   }
 
@@ -237,19 +203,132 @@ class DialogErrorChecking : public Gtk::Dialog {
     m_action_group->get_action("ExpandAll")->set_sensitive(state);
     m_action_group->get_action("CollapseAll")->set_sensitive(state);
 
+    set_document(doc);
     refresh();
   }
 
+  // Follow the edits of the document, the results of the last check are
+  // kept up to date (see on_idle).
+  void set_document(Document *doc) {
+    for (auto &connection : m_connections) {
+      connection.disconnect();
+    }
+    m_connections.clear();
+    m_idle.disconnect();
+
+    if (doc == NULL)
+      return;
+
+    Subtitles subtitles = doc->subtitles();
+    m_connections.push_back(subtitles.signal_inserted().connect(
+        sigc::mem_fun(*this, &DialogErrorChecking::on_subtitle_inserted)));
+    m_connections.push_back(subtitles.signal_deleted().connect(
+        sigc::mem_fun(*this, &DialogErrorChecking::on_subtitle_deleted)));
+    m_connections.push_back(subtitles.signal_reordered().connect(
+        sigc::mem_fun(*this, &DialogErrorChecking::on_results_outdated)));
+    m_connections.push_back(subtitles.signal_changed().connect(
+        sigc::mem_fun(*this, &DialogErrorChecking::on_subtitle_changed)));
+  }
+
+  // The results can't follow the edit, a full check is needed.
+  void on_results_outdated() {
+    m_outdated = true;
+    m_dirty.clear();
+  }
+
+  void on_subtitle_inserted(unsigned int index) {
+    if (m_outdated || !m_engine.insert(index)) {
+      on_results_outdated();
+      return;
+    }
+
+    // The following rows are shifted
+    std::set<unsigned int> dirty;
+    for (const auto &d : m_dirty) {
+      dirty.insert(d >= index ? d + 1 : d);
+    }
+    dirty.insert(index);
+    m_dirty.swap(dirty);
+    schedule();
+  }
+
+  void on_subtitle_deleted(unsigned int index) {
+    if (m_outdated || !m_engine.erase(index)) {
+      on_results_outdated();
+      return;
+    }
+
+    // The following rows are shifted, the neighbours are now side by side
+    std::set<unsigned int> dirty;
+    for (const auto &d : m_dirty) {
+      if (d != index)
+        dirty.insert(d > index ? d - 1 : d);
+    }
+    if (index > 0)
+      dirty.insert(index - 1);
+    if (index < m_engine.size())
+      dirty.insert(index);
+    m_dirty.swap(dirty);
+    schedule();
+  }
+
+  void on_subtitle_changed(unsigned int index) {
+    if (m_outdated || m_engine.is_running()) {
+      on_results_outdated();
+      return;
+    }
+
+    m_dirty.insert(index);
+    schedule();
+  }
+
+  void schedule() {
+    if (!m_idle)
+      m_idle = Glib::signal_idle().connect(
+          sigc::mem_fun(*this, &DialogErrorChecking::on_idle));
+  }
+
+  // Check again the edited subtitles and their neighbours.
+  bool on_idle() {
+    Document *doc = get_document();
+    if (doc == NULL || m_outdated)
+      return false;
+
+    std::set<unsigned int> dirty;
+    dirty.swap(m_dirty);
+    for (const auto &d : dirty) {
+      if (!m_engine.recheck(doc, d, d)) {
+        on_results_outdated();
+        break;
+      }
+    }
+    return false;
+  }
+
   // Return the current document.
   Document *get_document() {
     return SubtitleEditorWindow::get_instance()->get_current_document();
   }
 
   // Set the sort method.
+  // The view is rebuilt from the last results when they are up to date.
   void set_sort_type(SortType type) {
     m_sort_type = type;
 
-    refresh();
+    if (m_engine.is_running())
+      return;
+
+    // The pending edits first
+    if (m_idle) {
+      m_idle.disconnect();
+      on_idle();
+    }
+
+    Document *doc = get_document();
+    if (doc && !m_outdated && m_engine.size() == doc->subtitles().size())
+      update_view();
+    else
+      refresh();
   }
 
   // Return the sort type.
@@ -334,147 +413,118 @@ class DialogErrorChecking : public Gtk::Dialog {
 
   // Add an error in the node.
   // The label depend of the sort type.
-  void add_error(Gtk::TreeModel::Row &node, ErrorChecking::Info &info,
-                 ErrorChecking *checker) {
+  void add_error(Gtk::TreeModel::Row &node, unsigned int num,
+                 const ErrorCheckingEngine::Error &e) {
     Glib::ustring text;
 
     if (get_sort_type() == BY_CATEGORIES) {
-      Glib::ustring subtitle =
-          build_message(_("Subtitle n°<b>%d</b>"), info.currentSub.get_num());
-      Glib::ustring error = info.error;
+      Glib::ustring subtitle = build_message(_("Subtitle n°<b>%d</b>"), num);
 
-      text = build_message("%s\n%s", subtitle.c_str(), error.c_str());
+      text = build_message("%s\n%s", subtitle.c_str(), e.error.c_str());
     } else if (get_sort_type() == BY_SUBTITLES) {
-      Glib::ustring checker_label = checker->get_label();
-      Glib::ustring error = info.error;
+      Glib::ustring checker_label = e.checker->get_label();
 
-      text = build_message("%s\n%s", checker_label.c_str(), error.c_str());
+      text = build_message("%s\n%s", checker_label.c_str(), e.error.c_str());
     }
 
     Gtk::TreeIter it = m_model->append(node.children());
 
-    (*it)[m_column.num] = to_string(info.currentSub.get_num());
-    (*it)[m_column.checker] = checker;
+    (*it)[m_column.num] = to_string(num);
+    (*it)[m_column.checker] = e.checker;
     (*it)[m_column.text] = text;
-    (*it)[m_column.solution] = info.solution;
+    (*it)[m_column.solution] = e.solution;
   }
 
-  // Rebuild the model.
-  // Check errors.
+  // Check errors in the background.
+  // The model is rebuilt when the check is done.
   void refresh() {
+    m_engine.clear();
     m_model->clear();
     m_statusbar->push("");
 
+    // The snapshot of the check is read now, the following edits are
+    // outdated until the check is done
+    m_outdated = false;
+    m_dirty.clear();
+    m_idle.disconnect();
+
     Document *doc = get_document();
     if (doc == NULL)
       return;
 
-    if (get_sort_type() == BY_CATEGORIES)
-      check_by_categories(doc, m_checker_list);
-    else  // BY_SUBTITLES
-      check_by_subtitle(doc, m_checker_list);
+    std::vector<ErrorChecking *> checkers;
+    for (const auto &checker : m_checker_list) {
+      if (checker->get_active())
+        checkers.push_back(checker);
+    }
+
+    m_statusbar->push(_("Checking..."));
+    m_engine.check(doc, checkers);
   }
 
-  // Check errors by organizing them by type of error.
-  void check_by_categories(Document *doc,
-                           const std::vector<ErrorChecking *> &checkers) {
-    unsigned int count_error = 0;
+  void on_check_finished() {
+    update_view();
+  }
 
-    Subtitles subtitles = doc->subtitles();
+  // Rebuild the model from the results of the check.
+  void update_view() {
+    m_model->clear();
 
-    for (const auto &checker : checkers) {
-      if (checker->get_active() == false)
-        continue;
+    if (get_sort_type() == BY_CATEGORIES)
+      update_view_by_categories();
+    else  // BY_SUBTITLES
+      update_view_by_subtitle();
 
-      // Check all subtitles with the current checker
-      Gtk::TreeModel::Row row = *(m_model->append());
+    set_statusbar_error(m_engine.get_error_count());
+  }
 
-      Subtitle current, previous, next;
-      for (current = subtitles.get_first(); current; ++current) {
-        // get next
-        next = current;
-        ++next;
-
-        // info
-        ErrorChecking::Info info;
-        info.document = doc;
-        info.currentSub = current;
-        info.nextSub = next;
-        info.previousSub = previous;
-        info.tryToFix = false;
-
-        if (checker->execute(info)) {
-          add_error(row, info, checker);
-          ++count_error;
-        }
+  // Organize the errors by type of error.
+  void update_view_by_categories() {
+    for (const auto &checker : m_checker_list) {
+      Gtk::TreeIter node;
 
-        previous = current;
+      for (unsigned int i = 0; i < m_engine.size(); ++i) {
+        for (const auto &e : m_engine.get_errors(i)) {
+          if (e.checker != checker)
+            continue;
+
+          if (!node)
+            node = m_model->append();
+          Gtk::TreeModel::Row row = *node;
+          add_error(row, m_engine.get_num(i), e);
+        }
       }
 
-      // Update the node label or delete if it empty
-      if (row.children().empty()) {
-        m_model->erase(row);
-      } else {
+      // Update the node label, there's no node without error
+      if (node) {
+        Gtk::TreeModel::Row row = *node;
         row[m_column.checker] = checker;
 
         update_node_label(row);
       }
     }
-
-    set_statusbar_error(count_error);
   }
 
-  // Check errors by organizing them by subtitle.
-  void check_by_subtitle(Document *doc,
-                         const std::vector<ErrorChecking *> &checkers) {
-    std::vector<ErrorChecking *>::const_iterator checker_it;
-
-    Subtitles subtitles = doc->subtitles();
-
-    unsigned int count_error = 0;
-    Subtitle current, previous, next;
-    for (current = subtitles.get_first(); current; ++current) {
-      // get next
-      next = current;
-      ++next;
+  // Organize the errors by subtitle.
+  void update_view_by_subtitle() {
+    for (unsigned int i = 0; i < m_engine.size(); ++i) {
+      const std::vector<ErrorCheckingEngine::Error> &errors =
+          m_engine.get_errors(i);
+      if (errors.empty())
+        continue;
 
       Gtk::TreeModel::Row row = *(m_model->append());
 
-      for (const auto &checker : checkers) {
-        if (checker->get_active() == false)
-          continue;
-
-        // info
-        ErrorChecking::Info info;
-        info.document = doc;
-        info.currentSub = current;
-        info.nextSub = next;
-        info.previousSub = previous;
-        info.tryToFix = false;
-
-        if (checker->execute(info) == false)
-          continue;
-
-        add_error(row, info, checker);
-
-        ++count_error;
+      for (const auto &e : errors) {
+        add_error(row, m_engine.get_num(i), e);
       }
 
-      // Update the row label or remove the node if it's empty
-      if (row.children().empty()) {
-        m_model->erase(row);
-      } else {
-        row[m_column.checker] =
-            NULL;  // do not needs because is sort by subtitles
-        row[m_column.num] = to_string(current.get_num());
+      row[m_column.checker] =
+          NULL;  // do not needs because is sort by subtitles
+      row[m_column.num] = to_string(m_engine.get_num(i));
 
-        update_node_label(row);
-      }
-
-      previous = current;
+      update_node_label(row);
     }
-
-    set_statusbar_error(count_error);
   }
 
   // FIXME
@@ -540,6 +590,7 @@ class DialogErrorChecking : public Gtk::Dialog {
     info.previousSub = previous;
     info.tryToFix = true;
 
+    // The edited subtitles are checked again from on_subtitle_changed
     return error_checking_fix(checker, info);
   }
 
@@ -645,6 +696,9 @@ class DialogErrorChecking : public Gtk::Dialog {
 
   // Display the dialog preferences.
   void on_preferences() {
+    // The workers use the settings of the checkers
+    m_engine.cancel();
+
     ErrorCheckingGroup group;
     DialogErrorCheckingPreferences::create(*this, group);
 
@@ -662,6 +716,13 @@ class DialogErrorChecking : public Gtk::Dialog {
   Gtk::Statusbar *m_statusbar;
 
   ErrorCheckingGroup m_checker_list;
+  ErrorCheckingEngine m_engine;
+
+  // The edits of the document since the last check
+  std::vector<sigc::connection> m_connections;
+  sigc::connection m_idle;
+  std::set<unsigned int> m_dirty;
+  bool m_outdated{false};
 
   Glib::RefPtr<Gtk::ActionGroup> m_action_group;
 };
@@ -692,6 +753,16 @@ class ErrorCheckingPlugin : public Action {
                             _("Launch the error checking.")),
         sigc::mem_fun(*this, &ErrorCheckingPlugin::on_error_checker));
 
+    if (cfg::has_key("error-checking", "live") == false)
+      cfg::set_boolean("error-checking", "live", false);
+
+    action_group->add(
+        Gtk::ToggleAction::create(
+            "error-checking-live", _("_Live Error Checking"),
+            _("Check the errors while the subtitles are edited."),
+            cfg::get_boolean("error-checking", "live")),
+        sigc::mem_fun(*this, &ErrorCheckingPlugin::on_error_checker_live));
+
     // ui
     Glib::RefPtr<Gtk::UIManager> ui = get_ui_manager();
 
@@ -701,6 +772,11 @@ class ErrorCheckingPlugin : public Action {
 
     ui->add_ui(ui_id, "/menubar/menu-tools/checking", "error-checking",
                "error-checking");
+    ui->add_ui(ui_id, "/menubar/menu-tools/checking", "error-checking-live",
+               "error-checking-live");
+
+    if (cfg::get_boolean("error-checking", "live"))
+      m_live.reset(new LiveErrorChecking);
   }
 
   void deactivate() {
@@ -714,6 +790,8 @@ class ErrorCheckingPlugin : public Action {
     DialogErrorChecking *dialog = DialogErrorChecking::get_instance();
     if (dialog != nullptr)
       dialog->on_quit();
+
+    m_live.reset();
   }
 
   void update_ui() {
@@ -723,6 +801,9 @@ class ErrorCheckingPlugin : public Action {
 
     action_group->get_action("error-checking")->set_sensitive(visible);
 
+    if (m_live)
+      m_live->set_document(get_current_document());
+
     DialogErrorChecking *dialog = DialogErrorChecking::get_instance();
     if (dialog != NULL)
       dialog->on_current_document_changed(get_current_document());
@@ -733,9 +814,29 @@ class ErrorCheckingPlugin : public Action {
     DialogErrorChecking::create();
   }
 
+  // Enable or disable the live error checking.
+  void on_error_checker_live() {
+    Glib::RefPtr<Gtk::ToggleAction> action =
+        Glib::RefPtr<Gtk::ToggleAction>::cast_static(
+            action_group->get_action("error-checking-live"));
+    if (!action)
+      return;
+
+    bool state = action->get_active();
+    cfg::set_boolean("error-checking", "live", state);
+
+    if (state) {
+      m_live.reset(new LiveErrorChecking);
+      m_live->set_document(get_current_document());
+    } else {
+      m_live.reset();
+    }
+  }
+
  protected:
   Gtk::UIManager::ui_merge_id ui_id;
   Glib::RefPtr<Gtk::ActionGroup> action_group;
+  std::unique_ptr<LiveErrorChecking> m_live;
 };
 
 REGISTER_EXTENSION(ErrorCheckingPlugin)
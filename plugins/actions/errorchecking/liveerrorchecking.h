@@ -0,0 +1,302 @@
+#pragma once
+
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://kitone.github.io/subtitleeditor/
+// https://github.com/kitone/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include <documents.h>
+#include <set>
+#include <vector>
+#include "errorcheckinggroup.h"
+
+// Keep the errors of the subtitles of a document up to date while it's
+// edited.
+//
+// The rows touched by the commands (inserted, deleted or changed, undo and
+// redo included) are marked dirty from the signals of the subtitles, then in
+// the next idle only those rows and their neighbours are checked again.
+// A copy of the values of the rows is kept, so a change that doesn't touch
+// the checked values (like the number) is ignored.
+//
+// The result is a bitmap by subtitle (Subtitle::get_errors), the bit is the
+// position of the checker in the ErrorCheckingGroup. The bitmap isn't a value
+// of the model, only "subtitle-errors-changed" is emitted when it changes.
+class LiveErrorChecking : public sigc::trackable {
+ public:
+  LiveErrorChecking() : m_document(nullptr), m_full(false) {
+    init_settings();
+
+    cfg::signal_changed("timing").connect(
+        sigc::mem_fun(*this, &LiveErrorChecking::on_config_changed));
+    for (const auto &checker : m_checkers) {
+      cfg::signal_changed(checker->get_name())
+          .connect(sigc::mem_fun(*this, &LiveErrorChecking::on_config_changed));
+    }
+    se::documents::signal_deleted().connect(
+        sigc::mem_fun(*this, &LiveErrorChecking::on_document_deleted));
+  }
+
+  ~LiveErrorChecking() {
+    set_document(nullptr);
+  }
+
+  // Check the document. The errors of the previous document are cleared.
+  void set_document(Document *doc) {
+    if (doc == m_document)
+      return;
+
+    se_dbg(SE_DBG_PLUGINS);
+
+    if (m_document)
+      clear_errors();
+    release();
+
+    m_document = doc;
+    if (m_document == nullptr)
+      return;
+
+    Subtitles subtitles = m_document->subtitles();
+    m_connections.push_back(subtitles.signal_inserted().connect(
+        sigc::mem_fun(*this, &LiveErrorChecking::on_row_inserted)));
+    m_connections.push_back(subtitles.signal_deleted().connect(
+        sigc::mem_fun(*this, &LiveErrorChecking::on_row_deleted)));
+    m_connections.push_back(subtitles.signal_reordered().connect(
+        sigc::mem_fun(*this, &LiveErrorChecking::on_rows_reordered)));
+    m_connections.push_back(subtitles.signal_changed().connect(
+        sigc::mem_fun(*this, &LiveErrorChecking::on_row_changed)));
+
+    m_full = true;
+    schedule();
+  }
+
+ protected:
+  // Disconnect from the document without touching it.
+  void release() {
+    for (auto &connection : m_connections) {
+      connection.disconnect();
+    }
+    m_connections.clear();
+    m_idle.disconnect();
+    m_snapshot.clear();
+    m_dirty.clear();
+    m_full = false;
+    m_document = nullptr;
+  }
+
+  // Remove the errors of the current document.
+  void clear_errors() {
+    bool changed = false;
+    for (Subtitle sub = m_document->subtitles().get_first(); sub; ++sub) {
+      if (sub.get_errors() != 0) {
+        sub.set_errors(0);
+        changed = true;
+      }
+    }
+
+    if (changed)
+      m_document->emit_signal("subtitle-errors-changed");
+  }
+
+  void on_document_deleted(Document *doc) {
+    if (doc == m_document)
+      release();
+  }
+
+  // The state of the checkers is read once, not for each subtitle.
+  void init_settings() {
+    m_checkers.init_settings();
+
+    m_active.clear();
+    for (const auto &checker : m_checkers) {
+      m_active.push_back(checker->get_active());
+    }
+  }
+
+  // The settings of the checkers have changed, check all the document.
+  void on_config_changed(const Glib::ustring &, const Glib::ustring &) {
+    init_settings();
+
+    if (m_document) {
+      m_full = true;
+      schedule();
+    }
+  }
+
+  void on_row_inserted(unsigned int index) {
+    if (m_full || index > m_snapshot.size()) {
+      m_full = true;
+      schedule();
+      return;
+    }
+
+    m_snapshot.insert(m_snapshot.begin() + index, ErrorChecking::Data());
+
+    // The following rows are shifted
+    std::set<unsigned int> dirty;
+    for (const auto &d : m_dirty) {
+      dirty.insert(d >= index ? d + 1 : d);
+    }
+    dirty.insert(index);
+    m_dirty.swap(dirty);
+
+    schedule();
+  }
+
+  void on_row_deleted(unsigned int index) {
+    if (m_full || index >= m_snapshot.size()) {
+      m_full = true;
+      schedule();
+      return;
+    }
+
+    m_snapshot.erase(m_snapshot.begin() + index);
+
+    // The following rows are shifted, the neighbours are now side by side
+    std::set<unsigned int> dirty;
+    for (const auto &d : m_dirty) {
+      if (d != index)
+        dirty.insert(d > index ? d - 1 : d);
+    }
+    if (index > 0)
+      dirty.insert(index - 1);
+    if (index < m_snapshot.size())
+      dirty.insert(index);
+    m_dirty.swap(dirty);
+
+    schedule();
+  }
+
+  void on_rows_reordered() {
+    m_full = true;
+    schedule();
+  }
+
+  // Only the changes of the checked values mark the row dirty.
+  void on_row_changed(unsigned int index) {
+    if (m_full)
+      return;
+
+    if (index >= m_snapshot.size()) {
+      m_full = true;
+      schedule();
+      return;
+    }
+
+    Subtitle sub = m_document->subtitles().get(index + 1);
+    ErrorChecking::Data data(sub);
+    ErrorChecking::Data &old = m_snapshot[index];
+    if (data.start == old.start && data.end == old.end &&
+        data.text == old.text &&
+        data.characters_per_line_text == old.characters_per_line_text &&
+        data.characters_per_second_text == old.characters_per_second_text) {
+      old.num = data.num;
+      return;
+    }
+
+    old = data;
+    m_dirty.insert(index);
+    schedule();
+  }
+
+  void schedule() {
+    if (!m_idle)
+      m_idle = Glib::signal_idle().connect(
+          sigc::mem_fun(*this, &LiveErrorChecking::on_idle));
+  }
+
+  // Check the dirty rows and their neighbours, or all the document.
+  bool on_idle() {
+    if (m_document == nullptr)
+      return false;
+
+    Subtitles subtitles = m_document->subtitles();
+
+    std::set<unsigned int> indexes;
+    if (m_full) {
+      m_snapshot.clear();
+      for (Subtitle sub = subtitles.get_first(); sub; ++sub) {
+        m_snapshot.push_back(ErrorChecking::Data(sub));
+      }
+      for (unsigned int i = 0; i < m_snapshot.size(); ++i) {
+        indexes.insert(indexes.end(), i);
+      }
+    } else {
+      for (const auto &d : m_dirty) {
+        if (d > 0)
+          indexes.insert(d - 1);
+        indexes.insert(d);
+        if (d + 1 < m_snapshot.size())
+          indexes.insert(d + 1);
+      }
+    }
+    m_full = false;
+    m_dirty.clear();
+
+    se_dbg_msg(SE_DBG_PLUGINS, "check %d subtitles",
+               static_cast<int>(indexes.size()));
+
+    bool changed = false;
+    for (const auto &index : indexes) {
+      if (index >= m_snapshot.size())
+        break;
+
+      guint errors = check(index);
+
+      Subtitle sub = subtitles.get(index + 1);
+      if (sub.get_errors() != errors) {
+        sub.set_errors(errors);
+        changed = true;
+      }
+    }
+
+    if (changed)
+      m_document->emit_signal("subtitle-errors-changed");
+    return false;
+  }
+
+  // Return the bitmap of the errors of the subtitle.
+  guint check(unsigned int index) {
+    const ErrorChecking::Data *previous =
+        (index > 0) ? &m_snapshot[index - 1] : nullptr;
+    const ErrorChecking::Data *next =
+        (index + 1 < m_snapshot.size()) ? &m_snapshot[index + 1] : nullptr;
+
+    guint errors = 0;
+    Glib::ustring error, solution;
+    for (unsigned int i = 0; i < m_checkers.size(); ++i) {
+      if (m_active[i] && m_checkers[i]->detect(previous, m_snapshot[index],
+                                               next, error, solution))
+        errors |= (1u << i);
+    }
+    return errors;
+  }
+
+ protected:
+  Document *m_document;
+  ErrorCheckingGroup m_checkers;
+  std::vector<bool> m_active;
+
+  // Copy of the values of the rows
+  std::vector<ErrorChecking::Data> m_snapshot;
+  std::set<unsigned int> m_dirty;
+  bool m_full;
+
+  std::vector<sigc::connection> m_connections;
+  sigc::connection m_idle;
+};
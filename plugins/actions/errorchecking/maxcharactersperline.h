@@ -35,28 +35,22 @@ class MaxCharactersPerLine : public ErrorChecking {
     m_maxCPL = cfg::get_int("timing", "max-characters-per-line");
   }
 
-  virtual bool execute(Info &info) {
-    std::istringstream iss(info.currentSub.get_characters_per_line_text());
+  virtual bool detect(const Data *, const Data &current, const Data *,
+                      Glib::ustring &error, Glib::ustring &solution) const {
+    std::istringstream iss(current.characters_per_line_text);
     std::string line;
 
     while (std::getline(iss, line)) {
       int number = utility::string_to_int(line);
 
       if (number > m_maxCPL) {
-        if (info.tryToFix) {
-          info.currentSub.set_text(
-              word_wrap(info.currentSub.get_text(), m_maxCPL));
-          return true;
-        }
-
-        info.error = build_message(
+        error = build_message(
             ngettext("Subtitle has a too long line: <b>1 character</b>",
                      "Subtitle has a too long line: <b>%i characters</b>",
                      number),
             number);
-        info.solution = build_message(
-            _("<b>Automatic correction:</b>\n%s"),
-            word_wrap(info.currentSub.get_text(), m_maxCPL).c_str());
+        solution = build_message(_("<b>Automatic correction:</b>\n%s"),
+                                 word_wrap(current.text, m_maxCPL).c_str());
         return true;
       }
     }
@@ -64,7 +58,13 @@ class MaxCharactersPerLine : public ErrorChecking {
     return false;
   }
 
-  Glib::ustring word_wrap(Glib::ustring str, Glib::ustring::size_type width) {
+  virtual bool fix(Info &info) {
+    info.currentSub.set_text(word_wrap(info.currentSub.get_text(), m_maxCPL));
+    return true;
+  }
+
+  Glib::ustring word_wrap(Glib::ustring str,
+                          Glib::ustring::size_type width) const {
     Glib::ustring::size_type curWidth = width;
     Glib::ustring::size_type spacePos;
     while (curWidth < str.length()) {
@@ -37,26 +37,32 @@ class MaxCharactersPerSecond : public ErrorChecking {
     m_maxCPS = cfg::get_double("timing", "max-characters-per-second");
   }
 
-  bool execute(Info &info) {
-    if ((info.currentSub.check_cps_text(0, m_maxCPS) <= 0) || m_maxCPS == 0)
+  bool detect(const Data *, const Data &current, const Data *,
+              Glib::ustring &error, Glib::ustring &solution) const {
+    if ((Subtitle::check_cps(current.characters_per_second_text, 0,
+                             m_maxCPS) <= 0) ||
+        m_maxCPS == 0)
       return false;
 
     SubtitleTime duration(
-        utility::get_min_duration_msecs(info.currentSub.get_text(), m_maxCPS));
-
-    if (info.tryToFix) {
-      info.currentSub.set_duration(duration);
-      return true;
-    }
+        utility::get_min_duration_msecs(current.text, m_maxCPS));
 
-    info.error = build_message(
+    error = build_message(
         _("There are too many characters per second: <b>%.1f chars/s</b>"),
-        info.currentSub.get_characters_per_second_text());
+        current.characters_per_second_text);
+
+    solution = build_message(_("<b>Automatic correction:</b> change "
+                               "current subtitle duration to %s."),
+                             duration.str().c_str());
+
+    return true;
+  }
 
-    info.solution = build_message(_("<b>Automatic correction:</b> change "
-                                    "current subtitle duration to %s."),
-                                  duration.str().c_str());
+  bool fix(Info &info) {
+    SubtitleTime duration(
+        utility::get_min_duration_msecs(info.currentSub.get_text(), m_maxCPS));
 
+    info.currentSub.set_duration(duration);
     return true;
   }
 
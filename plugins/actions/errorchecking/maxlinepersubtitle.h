@@ -35,8 +35,9 @@ class MaxLinePerSubtitle : public ErrorChecking {
     m_maxLPS = cfg::get_int("timing", "max-line-per-subtitle");
   }
 
-  virtual bool execute(Info &info) {
-    std::istringstream iss(info.currentSub.get_characters_per_line_text());
+  virtual bool detect(const Data *, const Data &current, const Data *,
+                      Glib::ustring &error, Glib::ustring &solution) const {
+    std::istringstream iss(current.characters_per_line_text);
     std::string line;
 
     int count = 0;
@@ -47,21 +48,21 @@ class MaxLinePerSubtitle : public ErrorChecking {
     if (count <= m_maxLPS)
       return false;
 
-    if (info.tryToFix) {
-      // not implemented
-      return false;
-    }
-
-    info.error = build_message(
+    error = build_message(
         ngettext("Subtitle has too many lines: <b>1 line</b>",
                  "Subtitle has too many lines: <b>%i lines</b>", count),
         count);
-    info.solution =
+    solution =
         _("<b>Automatic correction:</b> unavailable, correct the error "
           "manually.");
     return true;
   }
 
+  virtual bool fix(Info &) {
+    // not implemented
+    return false;
+  }
+
  protected:
   int m_maxLPS;
 };
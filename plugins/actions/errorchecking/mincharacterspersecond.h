@@ -37,27 +37,32 @@ class MinCharactersPerSecond : public ErrorChecking {
     m_minCPS = cfg::get_double("timing", "min-characters-per-second");
   }
 
-  bool execute(Info &info) {
-    if ((info.currentSub.check_cps_text(m_minCPS, (m_minCPS + 1)) >= 0) ||
+  bool detect(const Data *, const Data &current, const Data *,
+              Glib::ustring &error, Glib::ustring &solution) const {
+    if ((Subtitle::check_cps(current.characters_per_second_text, m_minCPS,
+                             (m_minCPS + 1)) >= 0) ||
         m_minCPS == 0)
       return false;
 
     SubtitleTime duration(
-        utility::get_min_duration_msecs(info.currentSub.get_text(), m_minCPS));
-
-    if (info.tryToFix) {
-      info.currentSub.set_duration(duration);
-      return true;
-    }
+        utility::get_min_duration_msecs(current.text, m_minCPS));
 
-    info.error = build_message(
+    error = build_message(
         _("There are too few characters per second: <b>%.1f chars/s</b>"),
-        info.currentSub.get_characters_per_second_text());
+        current.characters_per_second_text);
+
+    solution = build_message(_("<b>Automatic correction:</b> change "
+                               "current subtitle duration to %s."),
+                             duration.str().c_str());
+
+    return true;
+  }
 
-    info.solution = build_message(_("<b>Automatic correction:</b> change "
-                                    "current subtitle duration to %s."),
-                                  duration.str().c_str());
+  bool fix(Info &info) {
+    SubtitleTime duration(
+        utility::get_min_duration_msecs(info.currentSub.get_text(), m_minCPS));
 
+    info.currentSub.set_duration(duration);
     return true;
   }
 
@@ -35,31 +35,31 @@ class MinDisplayTime : public ErrorChecking {
     m_min_display = cfg::get_int("timing", "min-display");
   }
 
-  bool execute(Info &info) {
-    SubtitleTime duration = info.currentSub.get_duration();
+  bool detect(const Data *, const Data &current, const Data *,
+              Glib::ustring &error, Glib::ustring &solution) const {
+    SubtitleTime duration = current.get_duration();
 
     if (duration.totalmsecs >= m_min_display)
       return false;
 
-    SubtitleTime new_end =
-        info.currentSub.get_start() + SubtitleTime(m_min_display);
+    SubtitleTime new_end = current.start + SubtitleTime(m_min_display);
 
-    if (info.tryToFix) {
-      info.currentSub.set_end(new_end);
-      return true;
-    }
+    error = build_message(_("Subtitle display time is too short: <b>%s</b>"),
+                          duration.str().c_str());
 
-    info.error =
-        build_message(_("Subtitle display time is too short: <b>%s</b>"),
-                      duration.str().c_str());
-
-    info.solution = build_message(
+    solution = build_message(
         _("<b>Automatic correction:</b> to change current subtitle end to %s."),
         new_end.str().c_str());
 
     return true;
   }
 
+  bool fix(Info &info) {
+    info.currentSub.set_end(info.currentSub.get_start() +
+                            SubtitleTime(m_min_display));
+    return true;
+  }
+
  protected:
   int m_min_display;
 };
@@ -36,34 +36,24 @@ class MinGapBetweenSubtitles : public ErrorChecking {
     m_minGBS = cfg::get_int("timing", "min-gap-between-subtitles");
   }
 
-  bool execute(Info &info) {
-    if (!info.nextSub)
+  bool detect(const Data *, const Data &current, const Data *next,
+              Glib::ustring &error, Glib::ustring &solution) const {
+    if (!next)
       return false;
 
-    long gap =
-        (info.nextSub.get_start() - info.currentSub.get_end()).totalmsecs;
+    long gap = (next->start - current.end).totalmsecs;
 
     if (gap >= m_minGBS)
       return false;
 
-    long middle = info.currentSub.get_end().totalmsecs + (gap / 2);
-    long halfGBS = m_minGBS / 2;
-
-    SubtitleTime new_current(middle - halfGBS);
-    SubtitleTime new_next(middle + halfGBS);
-
-    if (info.tryToFix) {
-      info.currentSub.set_end(new_current);
-      info.nextSub.set_start(new_next);
-
-      return true;
-    }
+    SubtitleTime new_current, new_next;
+    get_new_times(current.end, gap, new_current, new_next);
 
     // only error & solution
-    info.error =
+    error =
         build_message(_("Too short gap between subtitle: <b>%ims</b>"), gap);
 
-    info.solution =
+    solution =
         build_message(_("<b>Automatic correction:</b> to clip current subtitle "
                         "end to %s and to move next subtitle start to %s."),
                       new_current.str().c_str(), new_next.str().c_str());
@@ -71,6 +61,29 @@ class MinGapBetweenSubtitles : public ErrorChecking {
     return true;
   }
 
+  bool fix(Info &info) {
+    long gap =
+        (info.nextSub.get_start() - info.currentSub.get_end()).totalmsecs;
+
+    SubtitleTime new_current, new_next;
+    get_new_times(info.currentSub.get_end(), gap, new_current, new_next);
+
+    info.currentSub.set_end(new_current);
+    info.nextSub.set_start(new_next);
+
+    return true;
+  }
+
+  // The gap is centered on the middle of the current gap.
+  void get_new_times(const SubtitleTime &current_end, long gap,
+                     SubtitleTime &new_current, SubtitleTime &new_next) const {
+    long middle = current_end.totalmsecs + (gap / 2);
+    long halfGBS = m_minGBS / 2;
+
+    new_current = SubtitleTime(middle - halfGBS);
+    new_next = SubtitleTime(middle + halfGBS);
+  }
+
  protected:
   int m_minGBS;
 };
@@ -34,29 +34,29 @@ class Overlapping : public ErrorChecking {
     // mode = number
   }
 
-  // Check if the currentSub overlap on the next.
-  bool execute(Info &info) {
-    if (!info.nextSub)
+  // Check if the current overlap on the next.
+  bool detect(const Data *, const Data &current, const Data *next,
+              Glib::ustring &error, Glib::ustring &solution) const {
+    if (!next)
       return false;
 
-    if (info.currentSub.get_end() <= info.nextSub.get_start())
+    if (current.end <= next->start)
       return false;
 
-    long overlap =
-        (info.currentSub.get_end() - info.nextSub.get_start()).totalmsecs;
+    long overlap = (current.end - next->start).totalmsecs;
 
-    if (info.tryToFix) {
-      // not implemented
-      return false;
-    }
-
-    info.error = build_message(
+    error = build_message(
         _("Subtitle overlap on next subtitle: <b>%ims overlap</b>"), overlap);
 
-    info.solution =
+    solution =
         _("<b>Automatic correction:</b> unavailable, correct the error "
           "manually.");
 
     return true;
   }
+
+  bool fix(Info &) {
+    // not implemented
+    return false;
+  }
 };
@@ -62,7 +62,10 @@ enum PatternOptions { USE_REGEX = 1 << 1, IGNORE_CASE = 1 << 2 };
 enum ColumnOptions { TEXT = 1 << 1, TRANSLATION = 1 << 2 };
 
 // FaR Find and Replace
-class FaR {
+//
+// The options and the pattern are read from the config and the regular
+// expression is compiled once, then kept until the config changes.
+class FaR : public sigc::trackable {
  public:
   // Return an instance of the engine.
   static FaR &instance() {
@@ -70,6 +73,16 @@ class FaR {
     return engine;
   }
 
+  FaR() : m_dirty(true), m_pattern_options(0), m_columns_options(0) {
+    cfg::signal_changed("find-and-replace")
+        .connect(sigc::mem_fun(*this, &FaR::on_config_changed));
+  }
+
+  ~FaR() {
+    if (m_regex)
+      g_regex_unref(m_regex);
+  }
+
   // Returns the search option flag
   // IGNORE_CASE & USE_REGEX
   int get_pattern_options() {
@@ -113,7 +126,9 @@ class FaR {
     if (!sub)
       return false;
 
-    int columns_options = get_columns_options();
+    update_search();
+
+    int columns_options = m_columns_options;
     int current_column = (matchinfo) ? matchinfo->column : 0;
 
     if (columns_options & TEXT && current_column <= TEXT) {
@@ -150,9 +165,9 @@ class FaR {
       return false;
 
     Glib::ustring text = info.text;
-    Glib::ustring replacement = get_replacement();
-	
-	
+    // The references of a regular expression are already expanded
+    Glib::ustring replacement = info.replacement;
+
     try {
       text.replace(info.start, info.len, replacement);
     } catch (const std::exception &ex) {
@@ -176,6 +191,53 @@ class FaR {
   }
 
  protected:
+  void on_config_changed(const Glib::ustring &, const Glib::ustring &) {
+    m_dirty = true;
+  }
+
+  // Read the options and compile the pattern when the config has changed.
+  void update_search() {
+    if (!m_dirty)
+      return;
+    m_dirty = false;
+
+    se_dbg(SE_DBG_SEARCH);
+
+    m_pattern = get_pattern();
+    m_replacement = get_replacement();
+    m_pattern_options = get_pattern_options();
+    m_columns_options = get_columns_options();
+
+    if (m_regex) {
+      g_regex_unref(m_regex);
+      m_regex = nullptr;
+    }
+
+    if (m_pattern.empty())
+      return;
+
+    if (m_pattern_options & USE_REGEX) {
+      // G_REGEX_OPTIMIZE use the PCRE JIT when it's available
+      int compile_flags = G_REGEX_OPTIMIZE;
+      if (m_pattern_options & IGNORE_CASE)
+        compile_flags |= G_REGEX_CASELESS;
+
+      GError *error = NULL;
+      m_regex = g_regex_new(m_pattern.c_str(),
+                            (GRegexCompileFlags)compile_flags,
+                            (GRegexMatchFlags)0, &error);
+      if (error != NULL) {
+        std::cerr << "regex_exec error: " << error->message << std::endl;
+        g_error_free(error);
+        m_regex = nullptr;
+      }
+    } else {
+      m_literal = (m_pattern_options & IGNORE_CASE)
+                      ? m_pattern.lowercase().raw()
+                      : m_pattern.raw();
+    }
+  }
+
   bool find_in_text(const Glib::ustring &otext, MatchInfo *info) {
     Glib::ustring text = otext;
     Glib::ustring::size_type beginning = Glib::ustring::npos;
@@ -194,7 +256,7 @@ class FaR {
       if (beginning != Glib::ustring::npos)
         text = text.substr(beginning, text.size());
 
-      if (!find(get_pattern(), get_pattern_options(), text, info))
+      if (!find(text, info))
         return false;
 
       if (info) {  // Found, update matchinfo values
@@ -210,62 +272,62 @@ class FaR {
     return false;
   }
 
-  bool find(const Glib::ustring &pattern, int pattern_options,
-            const Glib::ustring &text, MatchInfo *info) {
-    if (pattern.empty())
+  bool find(const Glib::ustring &text, MatchInfo *info) {
+    if (m_pattern.empty())
       return false;
 
     bool found = false;
     Glib::ustring::size_type start, len;
+    Glib::ustring replacement = m_replacement;
 
-    if (pattern_options & USE_REGEX) {  // Search with regular expression
-      found = regex_exec(pattern, text, (pattern_options & IGNORE_CASE), start,
-                         len, info->replacement);
+    if (m_pattern_options & USE_REGEX) {  // Search with regular expression
+      found = regex_exec(text, start, len, replacement);
     } else {  // Without regular expression
-      Glib::ustring pat =
-          (pattern_options & IGNORE_CASE) ? pattern.lowercase() : pattern;
-      Glib::ustring txt =
-          (pattern_options & IGNORE_CASE) ? text.lowercase() : text;
-
-      Glib::ustring::size_type res = txt.find(pat);
-      if (res != Glib::ustring::npos) {
-        found = true;
-        start = res;
-        len = pattern.size();
-      }
+      found = literal_exec(text, start, len);
     }
 
     if (found && info) {
       info->found = true;
       info->start = start;
       info->len = len;
+      info->replacement = replacement;
     }
     return found;
   }
 
-  // FIXME: Remove Me
-  // Waiting the Glib::MatchInfo API in glibmm.
-  bool regex_exec(const Glib::ustring &pattern, const Glib::ustring &string,
-                  bool caseless, Glib::ustring::size_type &start,
+  // Search the literal pattern, a byte search on the UTF-8 text (memchr and
+  // memcmp) instead of comparing the characters one by one.
+  bool literal_exec(const Glib::ustring &text, Glib::ustring::size_type &start,
+                    Glib::ustring::size_type &len) {
+    Glib::ustring lowercase;
+    if (m_pattern_options & IGNORE_CASE)
+      lowercase = text.lowercase();
+    const std::string &txt =
+        (m_pattern_options & IGNORE_CASE) ? lowercase.raw() : text.raw();
+
+    std::string::size_type res = txt.find(m_literal);
+    if (res == std::string::npos)
+      return false;
+
+    // Convert the byte position to a character position
+    start = g_utf8_pointer_to_offset(txt.c_str(), txt.c_str() + res);
+    len = m_pattern.size();
+    return true;
+  }
+
+  // Match the compiled regular expression, the references of the
+  // replacement are expanded.
+  bool regex_exec(const Glib::ustring &string, Glib::ustring::size_type &start,
                   Glib::ustring::size_type &len, Glib::ustring &replacement) {
+    if (m_regex == nullptr)
+      return false;
+
     bool found = false;
-    GRegex *regex = NULL;
     GMatchInfo *match_info = NULL;
     GError *error = NULL;
     gboolean references = FALSE;
 
-    int compile_flags = (GRegexMatchFlags)0;
-    if (caseless)
-      compile_flags |= G_REGEX_CASELESS;
-    regex = g_regex_new(pattern.c_str(), (GRegexCompileFlags)compile_flags,
-                        (GRegexMatchFlags)0, &error);
-    if (error != NULL) {
-      std::cerr << "regex_exec error: " << error->message << std::endl;
-      g_error_free(error);
-      return false;
-    }
-
-    if (g_regex_match(regex, string.c_str(), (GRegexMatchFlags)0,
+    if (g_regex_match(m_regex, string.c_str(), (GRegexMatchFlags)0,
                       &match_info)) {
       if (g_match_info_matches(match_info)) {
         int start_pos, end_pos;
@@ -288,15 +350,35 @@ class FaR {
         // Expand any references in the replacement string
         references = TRUE;
         g_regex_check_replacement(replacement.c_str(), &references, &error);
-        if (error == NULL && references)
-          replacement = g_match_info_expand_references(
+        if (error != NULL) {
+          g_error_free(error);
+          error = NULL;
+        } else if (references) {
+          gchar *expanded = g_match_info_expand_references(
               match_info, replacement.c_str(), &error);
+          if (expanded != NULL) {
+            replacement = expanded;
+            g_free(expanded);
+          }
+          if (error != NULL)
+            g_error_free(error);
+        }
       }
     }
     g_match_info_free(match_info);
-    g_regex_unref(regex);
     return found;
   }
+
+ protected:
+  bool m_dirty;
+  Glib::ustring m_pattern;
+  Glib::ustring m_replacement;
+  int m_pattern_options;
+  int m_columns_options;
+  // The compiled pattern (USE_REGEX)
+  GRegex *m_regex{nullptr};
+  // The pattern (lowercase with IGNORE_CASE) without regular expression
+  std::string m_literal;
 };
 
 class ComboBoxEntryHistory : public Gtk::ComboBoxText {
@@ -123,10 +123,12 @@ class JoinDocumentPlugin : public Action {
 
           // The offset from the last original sub
           SubtitleTime offset = last_orig_sub.get_end();
+          doc->subtitles().begin_bulk_edit();
           for (Subtitle sub = first_new_subs; sub; ++sub) {
             sub.set_start_and_end(sub.get_start() + offset,
                                   sub.get_end() + offset);
           }
+          doc->subtitles().end_bulk_edit();
           // Make the user life easy by selecting the first new subtitle
           doc->subtitles().select(first_new_subs);
         }
@@ -25,8 +25,13 @@
 #include <utility.h>
 #include <iomanip>
 #include <iostream>
+#include "lumasad.h"
 #include "mediadecoder.h"
 
+// The frames are compared on a downscaled luma plane.
+#define FRAME_WIDTH 160
+#define FRAME_HEIGHT 90
+
 class KeyframesGeneratorUsingFrame : public Gtk::Dialog, public MediaDecoder {
  public:
   KeyframesGeneratorUsingFrame(const Glib::ustring &uri,
@@ -34,9 +39,7 @@ class KeyframesGeneratorUsingFrame : public Gtk::Dialog, public MediaDecoder {
       : Gtk::Dialog(_("Generate Keyframes"), true),
         MediaDecoder(1000),
         m_duration(0),
-        m_prev_frame_size(0),
-        m_prev_frame(NULL),
-        m_difference(0.2f) {
+        m_difference(0.12f) {
     set_border_width(12);
     set_default_size(300, -1);
     get_vbox()->pack_start(m_progressbar, false, false);
@@ -59,64 +62,59 @@ class KeyframesGeneratorUsingFrame : public Gtk::Dialog, public MediaDecoder {
   }
 
   ~KeyframesGeneratorUsingFrame(void) {
-    delete[] m_prev_frame;
+    destroy_pipeline();
   }
 
+  // The luma difference is about 0.6 of the old max channel difference on
+  // a scene cut, a new key is used so the old value (0.2) isn't read as a
+  // luma difference.
   void read_config() {
-    if (cfg::has_key("KeyframesGeneratorUsingFrame", "difference")) {
-      cfg::set_string("KeyframesGeneratorUsingFrame", "difference", "0.2");
-      cfg::set_comment("KeyframesGeneratorUsingFrame", "difference",
-                       "difference between frames as percent");
+    if (!cfg::has_key("KeyframesGeneratorUsingFrame", "luma-difference")) {
+      cfg::set_string("KeyframesGeneratorUsingFrame", "luma-difference",
+                      "0.12");
+      cfg::set_comment("KeyframesGeneratorUsingFrame", "luma-difference",
+                       "difference of luma between frames as percent");
     }
-    m_difference = cfg::get_float("KeyframesGeneratorUsingFrame", "difference");
+    m_difference =
+        cfg::get_float("KeyframesGeneratorUsingFrame", "luma-difference");
   }
 
   // Check buffer and try to catch keyframes.
   void on_video_identity_handoff(const Glib::RefPtr<Gst::Buffer> &buf,
                                  const Glib::RefPtr<Gst::Pad> &) {
-    GstMapInfo map;
-    gst_buffer_map(GST_BUFFER(buf->gobj()), &map, GST_MAP_READ);
+    // first frame or scene cut
+    if (!m_prev_frame || compare_frame(m_prev_frame, buf))
+      m_values.push_back(buf->get_pts() / GST_MSECOND);
 
-    // first frame or change of buffer size, alloc & push
-    if (!m_prev_frame || map.size != m_prev_frame_size) {
-      delete[] m_prev_frame;
-      m_prev_frame_size = map.size;
-      m_prev_frame = new guint8[m_prev_frame_size];
+    // keep a reference to this frame instead of copying it
+    m_prev_frame = buf;
+  }
 
-      m_values.push_back(buf->get_pts() / GST_MSECOND);
-    } else if (compare_frame(m_prev_frame, map.data, map.size)) {
-      m_values.push_back(buf->get_pts() / GST_MSECOND);
+  // The frames are luma planes (GRAY8).
+  bool compare_frame(const Glib::RefPtr<Gst::Buffer> &old_frame,
+                     const Glib::RefPtr<Gst::Buffer> &new_frame) {
+    GstMapInfo old_map, new_map;
+    if (!gst_buffer_map(GST_BUFFER(old_frame->gobj()), &old_map, GST_MAP_READ))
+      return false;
+    if (!gst_buffer_map(GST_BUFFER(new_frame->gobj()), &new_map,
+                        GST_MAP_READ)) {
+      gst_buffer_unmap(GST_BUFFER(old_frame->gobj()), &old_map);
+      return false;
     }
-    // update the previous frame with this one
-    memcpy(m_prev_frame, map.data, map.size);
 
-    gst_buffer_unmap(GST_BUFFER(buf->gobj()), &map);
-  }
+    bool cut = true;
+    // a change of buffer size is a scene cut
+    if (old_map.size == new_map.size && new_map.size > 0) {
+      guint64 delta = luma_sad(old_map.data, new_map.data, new_map.size);
+      double full = static_cast<double>(new_map.size) * 255;
 
-  bool compare_frame(const guint8 *old_frame, const guint8 *new_frame,
-                     gsize size) {
-    guint64 delta = 0;
-    guint64 full = size / 3;
-
-    gulong diff, i, j;
-    long tmp;
-    // calculate difference between frames
-    for (i = 0; i < full; ++i) {
-      diff = 0;
-      // get max difference in individual color channels
-      for (j = 0; j < 3; ++j) {
-        tmp = (int)new_frame[3 * i + j] - (int)old_frame[3 * i + j];
-        if (tmp < 0)
-          tmp = -tmp;
-        diff = tmp > diff ? tmp : diff;
-      }
-      // add max color diff to total delta
-      delta += diff;
+      // >12% difference => scene cut
+      cut = (static_cast<double>(delta) / full > m_difference);
     }
-    full *= 255;
 
-    // >20% difference => scene cut
-    return ((double)delta / (double)full > m_difference);
+    gst_buffer_unmap(GST_BUFFER(new_frame->gobj()), &new_map);
+    gst_buffer_unmap(GST_BUFFER(old_frame->gobj()), &old_map);
+    return cut;
   }
 
   // Create video bin
@@ -127,20 +125,34 @@ class KeyframesGeneratorUsingFrame : public Gtk::Dialog, public MediaDecoder {
       if (structure_name.find("video") == Glib::ustring::npos)
         return Glib::RefPtr<Gst::Element>(NULL);
 
-      Glib::RefPtr<Gst::FakeSink> fakesink = Gst::FakeSink::create("fakesink");
+      // Only a small luma plane is needed to compare the frames, the
+      // conversion is done by GStreamer
+      Glib::RefPtr<Gst::Bin> videobin = Glib::RefPtr<Gst::Bin>::cast_dynamic(
+          Gst::Parse::create_bin(
+              Glib::ustring::compose("videoconvert ! videoscale ! "
+                                     "video/x-raw, format=GRAY8, "
+                                     "width=%1, height=%2 ! "
+                                     "fakesink name=fakesink",
+                                     FRAME_WIDTH, FRAME_HEIGHT),
+              true));
+
+      Glib::RefPtr<Gst::FakeSink> fakesink =
+          Glib::RefPtr<Gst::FakeSink>::cast_dynamic(
+              videobin->get_element("fakesink"));
       fakesink->set_sync(false);
       fakesink->property_silent() = true;
+      fakesink->property_enable_last_sample() = false;
       fakesink->property_signal_handoffs() = true;
       fakesink->signal_handoff().connect(sigc::mem_fun(
           *this, &KeyframesGeneratorUsingFrame::on_video_identity_handoff));
 
       // Set the new sink tp READY as well
-      Gst::StateChangeReturn retst = fakesink->set_state(Gst::STATE_READY);
+      Gst::StateChangeReturn retst = videobin->set_state(Gst::STATE_READY);
       if (retst == Gst::STATE_CHANGE_FAILURE)
         std::cerr << "Could not change state of new sink: " << retst
                   << std::endl;
 
-      return fakesink;
+      return videobin;
     } catch (std::runtime_error &ex) {
       std::cerr << "create_element runtime_error: " << ex.what() << std::endl;
     }
@@ -184,8 +196,7 @@ class KeyframesGeneratorUsingFrame : public Gtk::Dialog, public MediaDecoder {
 
   std::list<long> m_values;
   guint64 m_duration;
-  guint64 m_prev_frame_size;
-  guint8 *m_prev_frame;
+  Glib::RefPtr<Gst::Buffer> m_prev_frame;
   gfloat m_difference;
 };
 
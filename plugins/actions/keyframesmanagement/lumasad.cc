@@ -0,0 +1,86 @@
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://kitone.github.io/subtitleeditor/
+// https://github.com/kitone/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "lumasad.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+guint64 luma_sad_scalar(const guint8 *a, const guint8 *b, gsize size) {
+  guint64 sum = 0;
+  for (gsize i = 0; i < size; ++i)
+    sum += (a[i] > b[i]) ? a[i] - b[i] : b[i] - a[i];
+  return sum;
+}
+
+#if defined(HAVE_LUMA_SAD_SSE2)
+guint64 luma_sad_sse2(const guint8 *a, const guint8 *b, gsize size) {
+  __m128i acc = _mm_setzero_si128();
+  gsize i = 0;
+  for (; i + 16 <= size; i += 16) {
+    __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+    __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+    acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+  }
+  guint64 lanes[2];
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), acc);
+  return lanes[0] + lanes[1] + luma_sad_scalar(a + i, b + i, size - i);
+}
+#endif
+
+#if defined(HAVE_LUMA_SAD_AVX2)
+__attribute__((target("avx2"))) guint64 luma_sad_avx2(const guint8 *a,
+                                                       const guint8 *b,
+                                                       gsize size) {
+  __m256i acc = _mm256_setzero_si256();
+  gsize i = 0;
+  for (; i + 32 <= size; i += 32) {
+    __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+    __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+    acc = _mm256_add_epi64(acc, _mm256_sad_epu8(va, vb));
+  }
+  guint64 lanes[4];
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), acc);
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+         luma_sad_scalar(a + i, b + i, size - i);
+}
+
+bool luma_sad_avx2_supported() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+#endif
+
+LumaSadFunc get_luma_sad_func() {
+#if defined(HAVE_LUMA_SAD_AVX2)
+  if (luma_sad_avx2_supported())
+    return luma_sad_avx2;
+#endif
+#if defined(HAVE_LUMA_SAD_SSE2)
+  return luma_sad_sse2;
+#else
+  return luma_sad_scalar;
+#endif
+}
+
+guint64 luma_sad(const guint8 *a, const guint8 *b, gsize size) {
+  static const LumaSadFunc func = get_luma_sad_func();
+  return func(a, b, size);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://kitone.github.io/subtitleeditor/
+// https://github.com/kitone/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include <glib.h>
+
+// Sum of the absolute differences of two luma planes, used to detect the
+// scene cuts. The kernels are exposed for the benchmark (lumasadbench).
+
+typedef guint64 (*LumaSadFunc)(const guint8 *a, const guint8 *b, gsize size);
+
+guint64 luma_sad_scalar(const guint8 *a, const guint8 *b, gsize size);
+
+#if defined(__SSE2__)
+#define HAVE_LUMA_SAD_SSE2 1
+guint64 luma_sad_sse2(const guint8 *a, const guint8 *b, gsize size);
+#endif
+
+// Compiled for AVX2 whatever the flags of the build, only call it when the
+// cpu supports it (see luma_sad_avx2_supported).
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_LUMA_SAD_AVX2 1
+guint64 luma_sad_avx2(const guint8 *a, const guint8 *b, gsize size);
+bool luma_sad_avx2_supported();
+#endif
+
+// Return the best kernel for the cpu, chosen once at runtime.
+LumaSadFunc get_luma_sad_func();
+
+// Call the best kernel.
+guint64 luma_sad(const guint8 *a, const guint8 *b, gsize size);
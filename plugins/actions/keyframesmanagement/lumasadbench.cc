@@ -0,0 +1,184 @@
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://kitone.github.io/subtitleeditor/
+// https://github.com/kitone/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+// Benchmark of the luma SAD kernels (make check).
+//
+// The kernels are timed on synthetic 160x90 GRAY8 frames, the size of the
+// plane compared by KeyframesGeneratorUsingFrame, and must return the same
+// sums. The normalized difference of the synthetic pairs is compared with the
+// default threshold of the generator (0.12): a pair of frames of the same
+// scene (moved and noisy) must be below, a scene cut above.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "lumasad.h"
+
+static const int kWidth = 160;
+static const int kHeight = 90;
+static const double kThreshold = 0.12;
+
+typedef std::vector<guint8> Frame;
+
+// A scene: a gradient with a few rectangles, shifted by (dx, dy) with noise.
+static Frame make_frame(unsigned int scene, int dx, int dy, int noise,
+                        std::mt19937 &rng) {
+  std::mt19937 scene_rng(scene);
+  std::uniform_int_distribution<int> byte(0, 255);
+  int gx = byte(scene_rng) % 3 - 1;
+  int gy = byte(scene_rng) % 3 - 1;
+  int base = byte(scene_rng);
+
+  struct Rect {
+    int x, y, w, h, value;
+  };
+  std::vector<Rect> rects;
+  for (int i = 0; i < 6; ++i) {
+    rects.push_back(Rect{byte(scene_rng) % kWidth, byte(scene_rng) % kHeight,
+                         10 + byte(scene_rng) % 60, 10 + byte(scene_rng) % 40,
+                         byte(scene_rng)});
+  }
+
+  std::uniform_int_distribution<int> jitter(-noise, noise);
+  Frame frame(kWidth * kHeight);
+  for (int y = 0; y < kHeight; ++y) {
+    for (int x = 0; x < kWidth; ++x) {
+      int sx = x + dx, sy = y + dy;
+      int value = base + gx * sx + gy * sy;
+      for (const auto &r : rects) {
+        if (sx >= r.x && sx < r.x + r.w && sy >= r.y && sy < r.y + r.h)
+          value = r.value;
+      }
+      if (noise > 0)
+        value += jitter(rng);
+      value = std::max(0, std::min(255, value));
+      frame[y * kWidth + x] = static_cast<guint8>(value);
+    }
+  }
+  return frame;
+}
+
+static double normalized(guint64 sad, gsize size) {
+  return static_cast<double>(sad) / (static_cast<double>(size) * 255);
+}
+
+// Return the frames by second of the kernel over the pairs, and the sum of
+// all the results.
+static double bench(LumaSadFunc func, const std::vector<Frame> &frames,
+                    guint64 &total) {
+  const unsigned int rounds = 2000;
+  total = 0;
+  auto begin = std::chrono::steady_clock::now();
+  for (unsigned int r = 0; r < rounds; ++r) {
+    for (size_t i = 1; i < frames.size(); ++i) {
+      total += func(frames[i - 1].data(), frames[i].data(), frames[i].size());
+    }
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - begin;
+  return rounds * (frames.size() - 1) / elapsed.count();
+}
+
+int main() {
+  std::mt19937 rng(1);
+
+  // A clip with a cut every 8 frames, a small move and noise between them
+  std::vector<Frame> frames;
+  std::vector<bool> cuts;
+  for (unsigned int i = 0; i < 64; ++i) {
+    frames.push_back(make_frame(i / 8, i % 8, (i % 8) / 2, 6, rng));
+    cuts.push_back(i > 0 && i % 8 == 0);
+  }
+
+  struct Kernel {
+    const char *name;
+    LumaSadFunc func;
+  };
+  std::vector<Kernel> kernels = {{"scalar", luma_sad_scalar}};
+#if defined(HAVE_LUMA_SAD_SSE2)
+  kernels.push_back(Kernel{"sse2", luma_sad_sse2});
+#endif
+#if defined(HAVE_LUMA_SAD_AVX2)
+  if (luma_sad_avx2_supported())
+    kernels.push_back(Kernel{"avx2", luma_sad_avx2});
+  else
+    printf("avx2: not supported by the cpu\n");
+#endif
+
+  int failures = 0;
+
+  // The same sums, also with the sizes not multiple of the vector width
+  const guint8 *a = frames[0].data();
+  const guint8 *b = frames[9].data();
+  for (gsize size = 0; size <= frames[0].size();
+       size += (size < 100) ? 1 : 997) {
+    guint64 expected = luma_sad_scalar(a, b, size);
+    for (const auto &k : kernels) {
+      if (k.func(a, b, size) != expected) {
+        printf("%s: wrong sum for %lu bytes\n", k.name,
+               static_cast<unsigned long>(size));
+        ++failures;
+      }
+    }
+  }
+
+  guint64 reference = 0;
+  for (size_t i = 0; i < kernels.size(); ++i) {
+    guint64 total = 0;
+    double fps = bench(kernels[i].func, frames, total);
+    printf("%s: %.0f frames/s\n", kernels[i].name, fps);
+    if (i == 0)
+      reference = total;
+    else if (total != reference) {
+      printf("%s: the sums differ from scalar\n", kernels[i].name);
+      ++failures;
+    }
+  }
+
+  guint64 total = 0;
+  double fps = bench(get_luma_sad_func(), frames, total);
+  printf("dispatched: %.0f frames/s\n", fps);
+  if (total != reference) {
+    printf("dispatched: the sums differ from scalar\n");
+    ++failures;
+  }
+
+  // The default threshold against the synthetic clip
+  double max_same = 0, min_cut = 1;
+  for (size_t i = 1; i < frames.size(); ++i) {
+    double d = normalized(
+        luma_sad(frames[i - 1].data(), frames[i].data(), frames[i].size()),
+        frames[i].size());
+    if (cuts[i])
+      min_cut = std::min(min_cut, d);
+    else
+      max_same = std::max(max_same, d);
+  }
+  printf("same scene: max %.3f, scene cut: min %.3f, threshold %.2f\n",
+         max_same, min_cut, kThreshold);
+  if (max_same >= kThreshold || min_cut <= kThreshold) {
+    printf("the threshold doesn't split the synthetic clip\n");
+    ++failures;
+  }
+
+  return (failures > 0) ? 1 : 0;
+}
@@ -73,13 +73,17 @@ class DialogSplitDocument : public Gtk::Dialog {
     // Create new document based on the first one and rename it
     Document *newdoc = new Document(*doc, true);
     newdoc->setFilename(newdoc->getFilename() + "-par2");
+    newdoc->subtitles().begin_bulk_edit();
     newdoc->subtitles().remove(1, number - 1);
+    newdoc->subtitles().end_bulk_edit();
 
     se::documents::append(newdoc);
 
     // Remove subtitles used by the new one
     doc->start_command(_("Split document"));
+    doc->subtitles().begin_bulk_edit();
     doc->subtitles().remove(number, doc->subtitles().size());
+    doc->subtitles().end_bulk_edit();
     doc->finish_command();
 
     return newdoc;
@@ -148,7 +148,7 @@ class SplitSelectedSubtitlesPlugin : public Action {
         newsubs[i].set_translation("");
 	  }
       // We take the loop to calculate the total number of characters
-      total_chars += utility::get_stripped_text(lines[i]).size();
+      total_chars += utility::get_text_length_for_timing(lines[i]);
     }
 
     // Now we set the time for each subtitle
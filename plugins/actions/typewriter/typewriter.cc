@@ -190,11 +190,15 @@ class TypewriterPlugin : public Action {
     newsubs.push_back(original_subtitle);
 
     // Create subtitle foreach text in the array
-    // start at 1 because we already add the original subtitle in the list
-    for (guint c = 1; c < vtext.size(); ++c) {
-      Subtitle next = subtitles.insert_after(newsubs[c - 1]);
-      original_subtitle.copy_to(next);  // Copy all values (style, note...)
-      newsubs.push_back(next);
+    // start at 1 because we already add the original subtitle in the list,
+    // they are inserted at once after the original subtitle
+    if (vtext.size() > 1) {
+      Subtitle next =
+          subtitles.insert_after(original_subtitle, vtext.size() - 1);
+      for (guint c = 1; c < vtext.size(); ++c, ++next) {
+        original_subtitle.copy_to(next);  // Copy all values (style, note...)
+        newsubs.push_back(next);
+      }
     }
     // Update subtitles text from vtext
     for (guint i = 0; i < vtext.size(); ++i) {
@@ -18,183 +18,349 @@
 // You should have received a copy of the GNU General Public License
 // along with this program. If not, see <http://www.gnu.org/licenses/>.
 
-#include <gstreamermm.h>
+#include "waveformgenerator.h"
+#include <gst/app/gstappsink.h>
 #include <gtkmm.h>
 #include <utility.h>
-#include <waveform.h>
-#include <iomanip>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
-#include "mediadecoder.h"
-
-class WaveformGenerator : public Gtk::Dialog, public MediaDecoder {
- public:
-  WaveformGenerator(const Glib::ustring &uri, Glib::RefPtr<Waveform> &wf)
-      : Gtk::Dialog(_("Generate Waveform"), true),
-        MediaDecoder(1000),
-        m_duration(GST_CLOCK_TIME_NONE),
-        m_n_channels(0) {
-    se_dbg_msg(SE_DBG_PLUGINS, "uri=%s", uri.c_str());
-
-    set_border_width(12);
-    set_default_size(300, -1);
-    get_vbox()->pack_start(m_progressbar, false, false);
-    add_button(Gtk::Stock::CANCEL, Gtk::RESPONSE_CANCEL);
-    m_progressbar.set_text(_("Waiting..."));
-    show_all();
-
-    try {
-      create_pipeline(uri);
-
-      if (run() == Gtk::RESPONSE_OK) {
-        wf = Glib::RefPtr<Waveform>(new Waveform);
-        wf->m_duration = m_duration / GST_MSECOND;
-        wf->m_n_channels = m_n_channels;
-        for (guint i = 0; i < m_n_channels; ++i)
-          wf->m_channels[i] =
-              std::vector<double>(m_values[i].begin(), m_values[i].end());
-        wf->m_video_uri = uri;
-      }
-    } catch (const std::runtime_error &ex) {
-      std::cerr << ex.what() << std::endl;
-    }
-  }
 
-  // Create audio bin
-  Glib::RefPtr<Gst::Element> create_element(
-      const Glib::ustring &structure_name) {
-    se_dbg_msg(SE_DBG_PLUGINS, "structure_name=%s", structure_name.c_str());
-    try {
-      // We only need and want create the video sink
-      if (structure_name.find("audio") == Glib::ustring::npos)
-        return Glib::RefPtr<Gst::Element>(NULL);
-
-      Glib::RefPtr<Gst::Bin> audiobin = Glib::RefPtr<Gst::Bin>::cast_dynamic(
-          Gst::Parse::create_bin("audioconvert ! "
-                                 // "audioresample ! "
-                                 // "audio/x-raw-float, channels=1 ! "
-                                 "level name=level ! "
-                                 "fakesink name=asink",
-                                 true));
-      // Set the new sink tp READY as well
-      Gst::StateChangeReturn retst = audiobin->set_state(Gst::STATE_READY);
-      if (retst == Gst::STATE_CHANGE_FAILURE)
-        std::cerr << "Could not change state of new sink: " << retst
-                  << std::endl;
-
-      return Glib::RefPtr<Gst::Element>::cast_dynamic(audiobin);
-    } catch (std::runtime_error &ex) {
-      se_dbg_msg(SE_DBG_PLUGINS, "runtime_error=%s", ex.what());
-      std::cerr << "create_audio_bin: " << ex.what() << std::endl;
-    }
-    return Glib::RefPtr<Gst::Element>(NULL);
-  }
+WaveformGenerator::WaveformGenerator(const Glib::ustring &uri)
+    : MediaDecoder(kUpdateInterval),
+      m_uri(uri),
+      m_fraction(0),
+      m_finished(false),
+      m_n_channels(0),
+      m_n_peaks(0),
+      m_rate(0),
+      m_stream_channels(0),
+      m_first_channel(0),
+      m_frames_per_peak(0),
+      m_frames(0),
+      m_n_copied(0) {
+  se_dbg_msg(SE_DBG_PLUGINS, "uri=%s", uri.c_str());
 
-  // BUS MESSAGE
-  bool on_bus_message(const Glib::RefPtr<Gst::Bus> &bus,
-                      const Glib::RefPtr<Gst::Message> &msg) {
-    MediaDecoder::on_bus_message(bus, msg);
+  m_sum[0] = m_sum[1] = m_sum[2] = 0;
 
-    if (msg->get_message_type() == Gst::MESSAGE_ELEMENT) {
-      if (msg->get_structure().get_name() == "level")
-        return on_bus_message_element_level(msg);
-    }
-    return true;
+  try {
+    create_pipeline(uri);
+  } catch (const std::runtime_error &ex) {
+    std::cerr << ex.what() << std::endl;
   }
+}
 
-  // Update the progress bar
-  bool on_timeout() {
-    se_dbg(SE_DBG_PLUGINS);
+WaveformGenerator::~WaveformGenerator() {
+  // Stop the streaming thread before the members are destroyed
+  destroy_pipeline();
+}
 
-    if (!m_pipeline)
-      return false;
+Glib::RefPtr<Waveform> WaveformGenerator::get_waveform() {
+  return m_waveform;
+}
 
-    Gst::Format fmt = Gst::FORMAT_TIME;
-    gint64 pos = 0, len = 0;
-    if (m_pipeline->query_position(fmt, pos) &&
-        m_pipeline->query_duration(fmt, len)) {
-      double percent = static_cast<double>(pos) / static_cast<double>(len);
+Glib::ustring WaveformGenerator::get_uri() const {
+  return m_uri;
+}
 
-      percent = CLAMP(percent, 0.0, 1.0);
+double WaveformGenerator::get_fraction() const {
+  return m_fraction;
+}
 
-      m_progressbar.set_fraction(percent);
-      m_progressbar.set_text(time_to_string(pos) + " / " + time_to_string(len));
+sigc::signal<void> &WaveformGenerator::signal_progress() {
+  return m_signal_progress;
+}
 
-      return pos != len;
-    }
+sigc::signal<void, bool> &WaveformGenerator::signal_finished() {
+  return m_signal_finished;
+}
+
+// Create audio bin
+Glib::RefPtr<Gst::Element> WaveformGenerator::create_element(
+    const Glib::ustring &structure_name) {
+  se_dbg_msg(SE_DBG_PLUGINS, "structure_name=%s", structure_name.c_str());
+  try {
+    // We only need and want create the audio sink
+    if (structure_name.find("audio") == Glib::ustring::npos)
+      return Glib::RefPtr<Gst::Element>(NULL);
+
+    // Only the first audio stream is used
+    if (m_appsink)
+      return Glib::RefPtr<Gst::Element>(NULL);
+
+    Glib::ustring caps = Glib::ustring::compose(
+        "audio/x-raw, format=%1, layout=interleaved",
+        (G_BYTE_ORDER == G_LITTLE_ENDIAN) ? "F32LE" : "F32BE");
+
+    Glib::RefPtr<Gst::Bin> audiobin = Glib::RefPtr<Gst::Bin>::cast_dynamic(
+        Gst::Parse::create_bin("audioconvert ! " + caps +
+                                   " ! appsink name=asink sync=false",
+                               true));
+
+    m_appsink = Glib::RefPtr<Gst::AppSink>::cast_dynamic(
+        audiobin->get_element("asink"));
+    m_appsink->property_emit_signals() = true;
+    m_appsink->signal_new_sample().connect(
+        sigc::mem_fun(*this, &WaveformGenerator::on_new_sample));
+
+    // Set the new sink tp READY as well
+    Gst::StateChangeReturn retst = audiobin->set_state(Gst::STATE_READY);
+    if (retst == Gst::STATE_CHANGE_FAILURE)
+      std::cerr << "Could not change state of new sink: " << retst
+                << std::endl;
 
-    return true;
+    return Glib::RefPtr<Gst::Element>::cast_dynamic(audiobin);
+  } catch (std::runtime_error &ex) {
+    se_dbg_msg(SE_DBG_PLUGINS, "runtime_error=%s", ex.what());
+    std::cerr << "create_audio_bin: " << ex.what() << std::endl;
   }
+  return Glib::RefPtr<Gst::Element>(NULL);
+}
 
-  bool on_bus_message_element_level(Glib::RefPtr<Gst::Message> msg) {
-    se_dbg_msg(SE_DBG_PLUGINS, "type='%s' name='%s'",
-               GST_MESSAGE_TYPE_NAME(msg->gobj()),
-               GST_OBJECT_NAME(GST_MESSAGE_SRC(msg->gobj())));
+// Called from the streaming thread, the sample is reduced to peaks without
+// any allocation (except when the duration was wrong).
+Gst::FlowReturn WaveformGenerator::on_new_sample() {
+  GstSample *sample = gst_app_sink_pull_sample(m_appsink->gobj());
+  if (sample == NULL)
+    return Gst::FLOW_EOS;
 
-    Gst::Structure structure = msg->get_structure();
-    const GValue *array_val =
-        gst_structure_get_value(GST_STRUCTURE(structure.gobj()), "rms");
-    GValueArray *rms_arr =
-        static_cast<GValueArray *>(g_value_get_boxed(array_val));
+  Glib::Threads::Mutex::Lock lock(m_mutex);
 
-    gint num_channels = rms_arr->n_values;
+  if (m_rate == 0) {
+    GstStructure *st = gst_caps_get_structure(gst_sample_get_caps(sample), 0);
+    if (!gst_structure_get_int(st, "rate", &m_rate) ||
+        !gst_structure_get_int(st, "channels", &m_stream_channels) ||
+        m_rate <= 0 || m_stream_channels <= 0) {
+      gst_sample_unref(sample);
+      return Gst::FLOW_NOT_NEGOTIATED;
+    }
 
-    guint first_channel, last_channel;
-    if (num_channels >= 6) {
-      first_channel = 1;
+    // Same channels than the previous version (level element)
+    guint last_channel;
+    if (m_stream_channels >= 6) {
+      m_first_channel = 1;
       last_channel = 3;
-    } else if (num_channels == 5) {
-      first_channel = 1;
+    } else if (m_stream_channels == 5) {
+      m_first_channel = 1;
       last_channel = 2;
-    } else if (num_channels == 2) {
-      first_channel = 0;
+    } else if (m_stream_channels == 2) {
+      m_first_channel = 0;
       last_channel = 1;
     } else {
-      first_channel = last_channel = 0;
-    }
-    // build the number of channels
-    m_n_channels = last_channel - first_channel + 1;
-
-    // get peak from channels
-    for (guint c = first_channel, i = 0; c <= last_channel; ++c, ++i) {
-      double peak =
-          pow(10, g_value_get_double(g_value_array_get_nth(rms_arr, c)) / 20);
-      m_values[i].push_back(peak);
+      m_first_channel = last_channel = 0;
     }
-    return true;
+    m_n_channels = last_channel - m_first_channel + 1;
+    m_frames_per_peak =
+        std::max(1, m_rate / static_cast<gint>(kPeaksPerSecond));
+
+    gint64 duration = 0;
+    if (!gst_element_query_duration(GST_ELEMENT(m_appsink->gobj()),
+                                    GST_FORMAT_TIME, &duration))
+      duration = 0;
+    reserve_peaks(duration);
   }
 
-  void on_work_finished() {
-    se_dbg(SE_DBG_PLUGINS);
+  GstBuffer *buffer = gst_sample_get_buffer(sample);
+  GstMapInfo map;
+  if (buffer && gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+    add_samples(reinterpret_cast<const float *>(map.data),
+                map.size / (sizeof(float) * m_stream_channels));
+    gst_buffer_unmap(buffer, &map);
+  }
+  gst_sample_unref(sample);
+  return Gst::FLOW_OK;
+}
 
-    // set duration to position at eos
-    Gst::Format fmt = Gst::FORMAT_TIME;
-    gint64 pos = 0;
+// The peak is the RMS of the samples (like the level element), computed in
+// the linear scale.
+void WaveformGenerator::add_samples(const float *data, guint n_frames) {
+  const guint stride = m_stream_channels;
+  const float *frame = data + m_first_channel;
 
-    if (m_pipeline && m_pipeline->query_position(fmt, pos)) {
-      m_duration = pos;
-      response(Gtk::RESPONSE_OK);
-    } else {
-      GST_ELEMENT_ERROR(
-          m_pipeline->gobj(), STREAM, FAILED,
-          (_("Could not determinate the duration of the stream.")), (NULL));
+  for (guint f = 0; f < n_frames; ++f, frame += stride) {
+    for (guint c = 0; c < m_n_channels; ++c)
+      m_sum[c] += frame[c] * frame[c];
+
+    if (++m_frames < m_frames_per_peak)
+      continue;
+
+    if (m_n_peaks >= m_peaks[0].size())
+      reserve_peaks(0);
+
+    for (guint c = 0; c < m_n_channels; ++c) {
+      m_peaks[c][m_n_peaks] = std::min(1.0, std::sqrt(m_sum[c] / m_frames));
+      m_sum[c] = 0;
     }
+    ++m_n_peaks;
+    m_frames = 0;
+  }
+}
+
+// Without duration (or when it's too short) the buffer is doubled.
+void WaveformGenerator::reserve_peaks(gint64 duration) {
+  guint64 size = 0;
+  if (duration > 0)
+    size = gst_util_uint64_scale_ceil(duration, kPeaksPerSecond, GST_SECOND);
+  size = std::max(size, std::max<guint64>(m_peaks[0].size() * 2,
+                                          60 * kPeaksPerSecond));
+
+  se_dbg_msg(SE_DBG_PLUGINS, "peaks buffer size=%" G_GUINT64_FORMAT, size);
+
+  for (guint c = 0; c < m_n_channels; ++c)
+    m_peaks[c].resize(size, 0.0);
+}
+
+// Update the progress and the waveform
+bool WaveformGenerator::on_timeout() {
+  se_dbg(SE_DBG_PLUGINS);
+
+  if (!m_pipeline || m_finished)
+    return false;
+
+  Gst::Format fmt = Gst::FORMAT_TIME;
+  gint64 pos = 0, len = 0;
+  if (m_pipeline->query_position(fmt, pos) &&
+      m_pipeline->query_duration(fmt, len) && len > 0) {
+    m_fraction = CLAMP(static_cast<double>(pos) / len, 0.0, 1.0);
   }
 
-  void on_work_cancel() {
-    se_dbg(SE_DBG_PLUGINS);
+  if (update_waveform())
+    m_signal_progress.emit();
+  return true;
+}
+
+// The waveform has the size of the peaks buffer, the peaks not yet decoded
+// are null.
+bool WaveformGenerator::update_waveform() {
+  Glib::Threads::Mutex::Lock lock(m_mutex);
+
+  if (m_n_channels == 0 || m_n_peaks == m_n_copied)
+    return false;
+
+  guint64 size = m_peaks[0].size();
 
-    response(Gtk::RESPONSE_CANCEL);
+  if (!m_waveform) {
+    m_waveform = Glib::RefPtr<Waveform>(new Waveform);
+    m_waveform->m_video_uri = m_uri;
+    m_waveform->m_n_channels = m_n_channels;
   }
 
- protected:
-  Gtk::ProgressBar m_progressbar;
-  guint64 m_duration;
-  guint m_n_channels;
-  std::list<gdouble> m_values[3];
-};
-
-Glib::RefPtr<Waveform> generate_waveform_from_file(const Glib::ustring &uri) {
-  Glib::RefPtr<Waveform> wf;
-  WaveformGenerator ui(uri, wf);
-  return wf;
+  for (guint c = 0; c < m_n_channels; ++c) {
+    std::vector<double> &channel = m_waveform->m_channels[c];
+    if (channel.size() != size)
+      channel.resize(size, 0.0);
+    std::copy(m_peaks[c].begin() + m_n_copied, m_peaks[c].begin() + m_n_peaks,
+              channel.begin() + m_n_copied);
+  }
+  m_waveform->m_duration = size * 1000 / kPeaksPerSecond;
+  m_waveform->invalidate_levels();
+
+  m_n_copied = m_n_peaks;
+  return true;
+}
+
+void WaveformGenerator::on_work_finished() {
+  se_dbg(SE_DBG_PLUGINS);
+
+  // set duration to position at eos
+  Gst::Format fmt = Gst::FORMAT_TIME;
+  gint64 pos = 0;
+
+  if (!m_pipeline || !m_pipeline->query_position(fmt, pos)) {
+    GST_ELEMENT_ERROR(
+        m_pipeline->gobj(), STREAM, FAILED,
+        (_("Could not determinate the duration of the stream.")), (NULL));
+    return;
+  }
+
+  update_waveform();
+  m_finished = true;
+  m_fraction = 1.0;
+
+  if (!m_waveform) {
+    m_signal_finished.emit(false);
+    return;
+  }
+
+  // Remove the part of the buffer without peaks
+  for (guint c = 0; c < m_n_channels; ++c)
+    m_waveform->m_channels[c].resize(m_n_peaks);
+  m_waveform->m_duration = pos / GST_MSECOND;
+  m_waveform->invalidate_levels();
+
+  m_signal_finished.emit(true);
+}
+
+void WaveformGenerator::on_work_cancel() {
+  se_dbg(SE_DBG_PLUGINS);
+
+  if (m_finished)
+    return;
+  m_finished = true;
+  m_signal_finished.emit(false);
+}
+
+// Return the filenames of the cache of the media or an empty list if the
+// media can't be queried.
+static std::vector<std::string> get_cache_filenames(const Glib::ustring &uri) {
+  std::vector<std::string> filenames;
+  try {
+    Glib::RefPtr<Gio::File> file = Gio::File::create_for_uri(uri);
+    Glib::RefPtr<Gio::FileInfo> info = file->query_info(
+        G_FILE_ATTRIBUTE_STANDARD_SIZE "," G_FILE_ATTRIBUTE_TIME_MODIFIED);
+
+    std::string path = file->get_path();
+    if (path.empty())
+      return filenames;
+
+    std::string name = Glib::ustring::compose(
+        ".%1.%2-%3.wf", Glib::path_get_basename(path), info->get_size(),
+        info->get_attribute_uint64(G_FILE_ATTRIBUTE_TIME_MODIFIED));
+
+    filenames.push_back(
+        Glib::build_filename(Glib::path_get_dirname(path), name));
+    filenames.push_back(Glib::build_filename(
+        Glib::get_user_cache_dir(), "subtitleeditor", "waveform", name));
+  } catch (const Glib::Error &ex) {
+    se_dbg_msg(SE_DBG_PLUGINS, "Could not query the media: %s",
+               ex.what().c_str());
+  }
+  return filenames;
+}
+
+// Open the waveform of the media from the cache or return NULL.
+Glib::RefPtr<Waveform> open_waveform_from_cache(const Glib::ustring &uri) {
+  std::vector<std::string> filenames = get_cache_filenames(uri);
+  for (const auto &filename : filenames) {
+    if (!Glib::file_test(filename, Glib::FILE_TEST_IS_REGULAR))
+      continue;
+
+    se_dbg_msg(SE_DBG_PLUGINS, "cache=%s", filename.c_str());
+
+    Glib::RefPtr<Waveform> wf =
+        Waveform::create_from_file(Glib::filename_to_uri(filename));
+    if (wf)
+      return wf;
+  }
+  return Glib::RefPtr<Waveform>(NULL);
+}
+
+// Save the waveform next to the media, or in the user cache directory if
+// the directory of the media is not writable.
+bool save_waveform_in_cache(const Glib::RefPtr<Waveform> &wf) {
+  if (!wf)
+    return false;
+
+  std::vector<std::string> filenames = get_cache_filenames(wf->get_video_uri());
+  for (const auto &filename : filenames) {
+    std::string dirname = Glib::path_get_dirname(filename);
+    if (g_mkdir_with_parents(dirname.c_str(), 0700) != 0)
+      continue;
+
+    se_dbg_msg(SE_DBG_PLUGINS, "cache=%s", filename.c_str());
+
+    if (wf->save(Glib::filename_to_uri(filename)))
+      return true;
+  }
+  return false;
 }
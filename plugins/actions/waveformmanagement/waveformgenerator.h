@@ -0,0 +1,120 @@
+#pragma once
+
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://kitone.github.io/subtitleeditor/
+// https://github.com/kitone/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include <gstreamermm.h>
+#include <gstreamermm/appsink.h>
+#include <waveform.h>
+#include <vector>
+#include "mediadecoder.h"
+
+// Generate a Waveform from a media file in the background.
+//
+// The decoded audio is pulled from an appsink in the streaming thread and
+// reduced to RMS peaks (kPeaksPerSecond by channel) in a buffer allocated
+// once from the duration of the stream. The main loop copies the new peaks
+// in the waveform every kUpdateInterval msecs and emits signal_progress, so
+// the editor can display the waveform while it's filled.
+class WaveformGenerator : public MediaDecoder {
+ public:
+  static const guint kPeaksPerSecond = 100;
+  static const guint kUpdateInterval = 250;
+
+  explicit WaveformGenerator(const Glib::ustring &uri);
+
+  ~WaveformGenerator();
+
+  // Return the waveform. NULL until the duration of the stream is known.
+  Glib::RefPtr<Waveform> get_waveform();
+
+  // Return the uri of the media.
+  Glib::ustring get_uri() const;
+
+  // Return the progress of the generation [0, 1].
+  double get_fraction() const;
+
+  // New peaks are available in the waveform.
+  sigc::signal<void> &signal_progress();
+
+  // The generation is done, the argument is false when it's canceled or
+  // failed. Don't delete the generator from this signal.
+  sigc::signal<void, bool> &signal_finished();
+
+ protected:
+  // Create audio bin
+  Glib::RefPtr<Gst::Element> create_element(
+      const Glib::ustring &structure_name);
+
+  // Called from the streaming thread.
+  Gst::FlowReturn on_new_sample();
+
+  // Reduce the interleaved samples to peaks. Called with m_mutex locked.
+  void add_samples(const float *data, guint n_frames);
+
+  // Allocate the peaks buffer from the duration of the stream.
+  // Called with m_mutex locked.
+  void reserve_peaks(gint64 duration);
+
+  // Copy the new peaks in the waveform (main loop).
+  bool on_timeout();
+
+  // Copy the new peaks in the waveform. Return true if there are new peaks.
+  bool update_waveform();
+
+  void on_work_finished();
+
+  void on_work_cancel();
+
+ protected:
+  Glib::ustring m_uri;
+  Glib::RefPtr<Waveform> m_waveform;
+  Glib::RefPtr<Gst::AppSink> m_appsink;
+  double m_fraction;
+  bool m_finished;
+
+  // Shared with the streaming thread
+  Glib::Threads::Mutex m_mutex;
+  guint m_n_channels;
+  std::vector<double> m_peaks[3];
+  guint64 m_n_peaks;
+
+  // Only used by the streaming thread
+  gint m_rate;
+  gint m_stream_channels;
+  guint m_first_channel;
+  guint m_frames_per_peak;
+  guint m_frames;
+  double m_sum[3];
+
+  // Number of peaks copied in the waveform (main loop)
+  guint64 m_n_copied;
+
+  sigc::signal<void> m_signal_progress;
+  sigc::signal<void, bool> m_signal_finished;
+};
+
+// Open the waveform of the media from the cache or return NULL.
+Glib::RefPtr<Waveform> open_waveform_from_cache(const Glib::ustring &uri);
+
+// Save the waveform in the cache of the media. The cache is next to the
+// media file or in the user cache directory, keyed by the size and the
+// modification time of the media.
+bool save_waveform_in_cache(const Glib::RefPtr<Waveform> &wf);
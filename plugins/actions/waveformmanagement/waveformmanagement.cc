@@ -24,9 +24,8 @@
 #include <player.h>
 #include <utility.h>
 #include <waveformmanager.h>
-
-// Declared in waveformgenerator.cc
-Glib::RefPtr<Waveform> generate_waveform_from_file(const Glib::ustring& uri);
+#include <memory>
+#include "waveformgenerator.h"
 
 class WaveformManagement : public Action {
  public:
@@ -237,6 +236,8 @@ class WaveformManagement : public Action {
   void deactivate() {
     se_dbg(SE_DBG_PLUGINS);
 
+    m_generator.reset();
+
     Glib::RefPtr<Gtk::UIManager> ui = get_ui_manager();
 
     ui->remove_ui(ui_id);
@@ -322,16 +323,12 @@ class WaveformManagement : public Action {
       Glib::ustring uri = dialog.get_uri();
       Glib::RefPtr<Waveform> wf = Waveform::create_from_file(uri);
       if (wf) {
+        m_generator.reset();
         get_waveform_manager()->set_waveform(wf);
         add_in_recent_manager(wf->get_uri());
         update_player_from_waveform();
       } else {
-        wf = generate_waveform_from_file(uri);
-        if (wf) {
-          get_waveform_manager()->set_waveform(wf);
-          on_save_waveform();
-          update_player_from_waveform();
-        }
+        generate_waveform(uri);
       }
     }
   }
@@ -340,13 +337,63 @@ class WaveformManagement : public Action {
   void on_generate_from_player_file() {
     Glib::ustring uri = get_subtitleeditor_window()->get_player()->get_uri();
     if (uri.empty() == false) {
-      // get_waveform_manager()->generate_waveform(uri);
-      Glib::RefPtr<Waveform> wf = generate_waveform_from_file(uri);
-      if (wf) {
-        get_waveform_manager()->set_waveform(wf);
-        on_save_waveform();
-      }
+      generate_waveform(uri);
+    }
+  }
+
+  // Open the waveform of the media from the cache, otherwise the waveform is
+  // generated in the background and displayed while it's filled.
+  void generate_waveform(const Glib::ustring& uri) {
+    se_dbg_msg(SE_DBG_PLUGINS, "uri=%s", uri.c_str());
+
+    m_generator.reset();
+
+    Glib::RefPtr<Waveform> wf = open_waveform_from_cache(uri);
+    if (wf) {
+      get_waveform_manager()->set_waveform(wf);
+      update_player_from_waveform();
+      return;
+    }
+
+    m_generator.reset(new WaveformGenerator(uri));
+    m_generator->signal_progress().connect(
+        sigc::mem_fun(*this, &WaveformManagement::on_generator_progress));
+    m_generator->signal_finished().connect(
+        sigc::mem_fun(*this, &WaveformManagement::on_generator_finished));
+  }
+
+  // New peaks are available, the first time the waveform is set in the
+  // editor, after only the display is updated.
+  void on_generator_progress() {
+    Glib::RefPtr<Waveform> wf = m_generator->get_waveform();
+    if (!wf)
+      return;
+
+    if (get_waveform_manager()->get_waveform() != wf) {
+      get_waveform_manager()->set_waveform(wf);
+      update_player_from_waveform();
+    } else {
+      get_waveform_manager()->update_waveform();
+    }
+  }
+
+  void on_generator_finished(bool success) {
+    se_dbg_msg(SE_DBG_PLUGINS, "success=%d", success);
+
+    if (success) {
+      on_generator_progress();
+      save_waveform_in_cache(m_generator->get_waveform());
     }
+    // The generator can't be deleted from its own signal
+    Glib::signal_idle().connect(sigc::bind(
+        sigc::mem_fun(*this, &WaveformManagement::on_delete_generator),
+        m_generator.get()));
+  }
+
+  bool on_delete_generator(WaveformGenerator* generator) {
+    if (m_generator.get() == generator)
+      m_generator.reset();
+    return false;
   }
 
   // Generate an Sine Waveform
@@ -355,6 +402,8 @@ class WaveformManagement : public Action {
     if (player->get_state() == Player::NONE)
       return;
 
+    m_generator.reset();
+
     // Create and initialize Waveform
     Glib::RefPtr<Waveform> wf(new Waveform);
     wf->m_video_uri = player->get_uri();
@@ -404,6 +453,7 @@ class WaveformManagement : public Action {
 
     Glib::RefPtr<Waveform> wf(NULL);
 
+    m_generator.reset();
     get_waveform_manager()->set_waveform(wf);
   }
 
@@ -550,14 +600,17 @@ class WaveformManagement : public Action {
       se_dbg_msg(SE_DBG_PLUGINS, "uri=%s", cur->get_uri().c_str());
 
       Glib::RefPtr<Waveform> wf = Waveform::create_from_file(cur->get_uri());
-      if (wf)
+      if (wf) {
+        m_generator.reset();
         get_waveform_manager()->set_waveform(wf);
+      }
     }
   }
 
  protected:
   Gtk::UIManager::ui_merge_id ui_id;
   Glib::RefPtr<Gtk::ActionGroup> action_group;
+  std::unique_ptr<WaveformGenerator> m_generator;
 };
 
 
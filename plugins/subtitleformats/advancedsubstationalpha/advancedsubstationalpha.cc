@@ -24,6 +24,7 @@
 #include <gtkmm_utility.h>
 #include <utility.h>
 #include <cstdio>
+#include <cstring>
 #include <iomanip>
 #include <memory>
 
@@ -139,7 +140,7 @@ class AdvancedSubStationAlpha : public SubtitleFormatIO {
   }
 
   void open(Reader &file) {
-    std::vector<Glib::ustring> lines = file.get_lines();
+    const std::vector<Glib::ustring> &lines = file.get_lines();
 
     read_script_info(lines);
     read_styles(lines);
@@ -257,44 +258,120 @@ class AdvancedSubStationAlpha : public SubtitleFormatIO {
 
     Subtitles subtitles = document()->subtitles();
 
-    Glib::RefPtr<Glib::Regex> re = Glib::Regex::create(
-        "^Dialogue:\\s*([^,]*),([^,]*),([^,]*),\\**([^,]*),([^,]*),([^,]*),(["
-        "^,"
-        "]*),([^,]*),([^,]*),(.*)$");
-
+    Field fields[10];
     for (const auto &line : lines) {
-      if (!re->match(line))
-        continue;
-
-      std::vector<Glib::ustring> group = re->split(line);
-      if (group.size() == 1)
+      if (!split_dialogue(line.raw(), fields))
         continue;
 
       Subtitle sub = subtitles.append();
 
       // start, end times
-      sub.set_start_and_end(from_ass_time(group[2]), from_ass_time(group[3]));
+      sub.set_start_and_end(parse_ass_time(fields[1]),
+                            parse_ass_time(fields[2]));
 
-      // style
-      sub.set_style(group[4]);
+      // style, the '*' are ignored
+      Field style = fields[3];
+      while (style.begin < style.end && *style.begin == '*') ++style.begin;
+      sub.set_style(style.str());
 
       // name
-      sub.set_name(group[5]);
+      sub.set_name(fields[4].str());
 
       // margin lrv
-      sub.set_margin_l(group[6]);
-      sub.set_margin_r(group[7]);
-      sub.set_margin_v(group[8]);
+      sub.set_margin_l(fields[5].str());
+      sub.set_margin_r(fields[6].str());
+      sub.set_margin_v(fields[7].str());
 
       // effect
-      sub.set_effect((group[9]));
+      sub.set_effect(fields[8].str());
 
-      // text
-      utility::replace(group[10], "\\n", "\n");
-      utility::replace(group[10], "\\N", "\n");
+      // text, "\\n" and "\\N" are the line breaks
+      sub.set_text(unescape_text(fields[9]));
+    }
+  }
+
+  // A field of a line, [begin, end) point into the line.
+  struct Field {
+    const char *begin;
+    const char *end;
 
-      sub.set_text(group[10]);
+    Glib::ustring str() const {
+      return Glib::ustring(begin, end);
     }
+  };
+
+  // Split "Dialogue: Layer,Start,End,Style,Name,MarginL,MarginR,MarginV,
+  // Effect,Text" without copy. The text is the rest of the line (with the
+  // commas). Return false if it's not a dialogue line.
+  static bool split_dialogue(const std::string &line, Field fields[10]) {
+    static const char prefix[] = "Dialogue:";
+    static const std::size_t prefix_size = sizeof(prefix) - 1;
+
+    if (line.compare(0, prefix_size, prefix) != 0)
+      return false;
+
+    const char *p = line.data() + prefix_size;
+    const char *end = line.data() + line.size();
+    while (p < end && g_ascii_isspace(*p)) ++p;
+
+    for (unsigned int i = 0; i < 9; ++i) {
+      const char *comma =
+          static_cast<const char *>(std::memchr(p, ',', end - p));
+      if (comma == nullptr)
+        return false;
+      fields[i].begin = p;
+      fields[i].end = comma;
+      p = comma + 1;
+    }
+    fields[9].begin = p;
+    fields[9].end = end;
+    return true;
+  }
+
+  // Parse a number, return the position after the digits or nullptr.
+  static const char *parse_int(const char *p, const char *end, int &value) {
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+      negative = (*p++ == '-');
+
+    const char *digits = p;
+    value = 0;
+    while (p < end && g_ascii_isdigit(*p)) value = value * 10 + (*p++ - '0');
+    if (p == digits)
+      return nullptr;
+    if (negative)
+      value = -value;
+    return p;
+  }
+
+  // "H:MM:SS.CC" with integer arithmetic, like sscanf("%d:%d:%d.%d").
+  static SubtitleTime parse_ass_time(const Field &field) {
+    const char *p = field.begin;
+    const char *end = field.end;
+    while (p < end && g_ascii_isspace(*p)) ++p;
+
+    int h, m, s, cs;
+    if ((p = parse_int(p, end, h)) == nullptr || p == end || *p++ != ':' ||
+        (p = parse_int(p, end, m)) == nullptr || p == end || *p++ != ':' ||
+        (p = parse_int(p, end, s)) == nullptr || p == end || *p++ != '.' ||
+        (p = parse_int(p, end, cs)) == nullptr)
+      return SubtitleTime::null();
+    return SubtitleTime(h, m, s, cs * 10);
+  }
+
+  // Replace "\\n" and "\\N" by a new line in one pass.
+  static Glib::ustring unescape_text(const Field &field) {
+    std::string text;
+    text.reserve(field.end - field.begin);
+    for (const char *p = field.begin; p < field.end; ++p) {
+      if (*p == '\\' && p + 1 < field.end && (p[1] == 'n' || p[1] == 'N')) {
+        text.push_back('\n');
+        ++p;
+      } else {
+        text.push_back(*p);
+      }
+    }
+    return text;
   }
 
   // Write the block [Script Info]
@@ -454,15 +531,6 @@ class AdvancedSubStationAlpha : public SubtitleFormatIO {
                          time.seconds(), hundredths);
   }
 
-  // Convert time from ASS to SE
-  SubtitleTime from_ass_time(const Glib::ustring &t) {
-    int h, m, s, ms;
-    if (std::sscanf(t.c_str(), "%d:%d:%d.%d", &h, &m, &s, &ms) == 4)
-      return SubtitleTime(h, m, s, ms * 10);
-
-    return SubtitleTime::null();
-  }
-
   // Convert bool from SE to ASS
   // ASS: false == 0, true == -1
   Glib::ustring to_ass_bool(const Glib::ustring &value) {
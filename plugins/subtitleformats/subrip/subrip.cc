@@ -29,40 +29,25 @@
 class SubRip : public SubtitleFormatIO {
  public:
   void open(Reader &file) {
-    Glib::RefPtr<Glib::Regex> re_num = Glib::Regex::create("^\\d+$");
-
-    Glib::RefPtr<Glib::Regex> re_time = Glib::Regex::create(
-        "^(\\d+):(\\d+):(\\d+),(\\d+)\\s-->\\s(\\d+):(\\d+):(\\d+),(\\d+)");
-
-    int start[4], end[4];
+    SubtitleTime start, end;
     Subtitles subtitles = document()->subtitles();
 
-    Glib::ustring line;
+    // The lines are views into the data of the reader, only the text of the
+    // subtitle is copied
+    Reader::LineView line;
 
     while (file.getline(line)) {
       // Read the subtitle time "start --> end"
-      if (re_time->match(line)) {
-        std::vector<Glib::ustring> group = re_time->split(line);
-
-        start[0] = utility::string_to_int(group[1]);
-        start[1] = utility::string_to_int(group[2]);
-        start[2] = utility::string_to_int(group[3]);
-        start[3] = utility::string_to_int(group[4]);
-
-        end[0] = utility::string_to_int(group[5]);
-        end[1] = utility::string_to_int(group[6]);
-        end[2] = utility::string_to_int(group[7]);
-        end[3] = utility::string_to_int(group[8]);
-
-        Glib::ustring text;
+      if (parse_time_line(line.data, line.size, start, end)) {
+        std::string text;
         int count = 0;
 
         // Read the text lines
-        while (file.getline(line) && !line.empty()) {
+        while (file.getline(line) && line.size > 0) {
           if (count > 0)
             text += '\n';
 
-          text += line;
+          text.append(line.data, line.size);
 
           ++count;
         }
@@ -71,16 +56,50 @@ class SubRip : public SubtitleFormatIO {
         Subtitle sub = subtitles.append();
 
         sub.set_text(text);
-        sub.set_start_and_end(
-            SubtitleTime(start[0], start[1], start[2], start[3]),
-            SubtitleTime(end[0], end[1], end[2], end[3]));
+        sub.set_start_and_end(start, end);
       } else {
-        se_dbg_msg(SE_DBG_PLUGINS, "can not match time line: '%s'",
-                   line.c_str());
+        se_dbg_msg(SE_DBG_PLUGINS, "can not match time line: '%.*s'",
+                   static_cast<int>(line.size), line.data);
       }
     }
   }
 
+  // Parse the digits, return the position after them or nullptr.
+  static const char *parse_number(const char *p, const char *end, int &value) {
+    const char *digits = p;
+    value = 0;
+    while (p < end && g_ascii_isdigit(*p)) value = value * 10 + (*p++ - '0');
+    return (p == digits) ? nullptr : p;
+  }
+
+  // "H:M:S,MS", return the position after the time or nullptr.
+  static const char *parse_time(const char *p, const char *end,
+                                SubtitleTime &time) {
+    int h, m, s, ms;
+    if ((p = parse_number(p, end, h)) == nullptr || p == end || *p++ != ':' ||
+        (p = parse_number(p, end, m)) == nullptr || p == end || *p++ != ':' ||
+        (p = parse_number(p, end, s)) == nullptr || p == end || *p++ != ',' ||
+        (p = parse_number(p, end, ms)) == nullptr)
+      return nullptr;
+    time = SubtitleTime(h, m, s, ms);
+    return p;
+  }
+
+  // Read "start --> end" from the line buffer with integer arithmetic, the
+  // end of the line (coordinates) is ignored.
+  static bool parse_time_line(const char *line, gsize size,
+                              SubtitleTime &start, SubtitleTime &end) {
+    const char *p = line;
+    const char *e = p + size;
+
+    if ((p = parse_time(p, e, start)) == nullptr)
+      return false;
+    if (e - p < 5 || !g_ascii_isspace(p[0]) || p[1] != '-' || p[2] != '-' ||
+        p[3] != '>' || !g_ascii_isspace(p[4]))
+      return false;
+    return parse_time(p + 5, e, end) != nullptr;
+  }
+
   void save(Writer &file) {
     unsigned int count = 1;
     for (Subtitle sub = document()->subtitles().get_first(); sub;
@@ -269,7 +269,7 @@ class SubStationAlpha : public SubtitleFormatIO {
   }
 
   void open(Reader &file) {
-    std::vector<Glib::ustring> lines = file.get_lines();
+    const std::vector<Glib::ustring> &lines = file.get_lines();
 
     read_script_info(lines);
     read_styles(lines);
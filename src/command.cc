@@ -39,6 +39,24 @@ Glib::ustring Command::description() const {
   return m_description;
 }
 
+std::size_t Command::get_size() const {
+  return sizeof(Command) + m_description.bytes();
+}
+
+void Command::compress() {
+}
+
+std::size_t Command::get_size(
+    const std::map<Glib::ustring, Glib::ustring> &values) {
+  // The nodes of the map and the strings
+  std::size_t size = sizeof(values);
+  for (const auto &v : values) {
+    size += 4 * sizeof(void *) + sizeof(v) + v.first.bytes() +
+            v.second.bytes();
+  }
+  return size;
+}
+
 SubtitleModelPtr Command::get_document_subtitle_model() {
   return document()->get_subtitle_model();
 }
@@ -21,6 +21,7 @@
 // along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 #include <glibmm.h>
+#include <map>
 
 class Document;
 class SubtitleModel;
@@ -43,6 +44,18 @@ class Command {
 
   Glib::ustring description() const;
 
+  // Return an estimation of the memory used by the command (bytes).
+  virtual std::size_t get_size() const;
+
+  // Called when the command gets old in the history. A command holding a lot
+  // of data can compress it, it's uncompressed when it's used again.
+  virtual void compress();
+
+ protected:
+  // Return an estimation of the memory used by the values of a subtitle.
+  static std::size_t get_size(
+      const std::map<Glib::ustring, Glib::ustring> &values);
+
  protected:
   Document* m_document;
   Glib::ustring m_description;
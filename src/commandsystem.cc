@@ -18,6 +18,7 @@
 // You should have received a copy of the GNU General Public License
 // along with this program. If not, see <http://www.gnu.org/licenses/>.
 
+#include <algorithm>
 #include "cfg.h"
 #include "commandsystem.h"
 #include "document.h"
@@ -32,8 +33,15 @@ class SubtitleSelectionCommand : public Command {
 
     m_paths.resize(rows.size());
 
-    for (unsigned int i = 0; i < rows.size(); ++i)
+    m_size = Command::get_size() + sizeof(m_paths);
+    for (unsigned int i = 0; i < rows.size(); ++i) {
       m_paths[i] = rows[i].to_string();
+      m_size += sizeof(m_paths[i]) + m_paths[i].bytes();
+    }
+  }
+
+  std::size_t get_size() const {
+    return m_size;
   }
 
   void execute() {
@@ -56,6 +64,7 @@ class SubtitleSelectionCommand : public Command {
 
  protected:
   std::vector<Glib::ustring> m_paths;
+  std::size_t m_size;
 };
 
 CommandGroup::CommandGroup(const Glib::ustring &description)
@@ -78,6 +87,26 @@ void CommandGroup::add(Command *cmd) {
   m_stack.push_back(cmd);
 }
 
+Command *CommandGroup::get_last() {
+  if (m_stack.empty())
+    return nullptr;
+  return m_stack.back();
+}
+
+std::size_t CommandGroup::get_size() const {
+  std::size_t size = Command::get_size();
+  for (const auto &cmd : m_stack) {
+    size += cmd->get_size() + 3 * sizeof(void *);
+  }
+  return size;
+}
+
+void CommandGroup::compress() {
+  for (const auto &cmd : m_stack) {
+    cmd->compress();
+  }
+}
+
 void CommandGroup::execute() {
   se_dbg(SE_DBG_COMMAND);
 
@@ -99,6 +128,10 @@ void CommandGroup::restore() {
 CommandSystem::CommandSystem(Document &doc) : m_document(doc) {
   m_max_undo_stack = cfg::get_int("interface", "max-undo");
 
+  m_max_undo_memory = static_cast<std::size_t>(std::max(
+                         0, cfg::get_int("interface", "max-undo-memory"))) *
+                     1024 * 1024;
+
   cfg::signal_changed("interface")
       .connect(
           sigc::mem_fun(*this, &CommandSystem::on_config_interface_changed));
@@ -114,6 +147,10 @@ void CommandSystem::on_config_interface_changed(const Glib::ustring &key,
     int max = utility::string_to_int(value);
 
     m_max_undo_stack = max;
+  } else if (key == "max-undo-memory") {
+    m_max_undo_memory =
+        static_cast<std::size_t>(std::max(0, utility::string_to_int(value))) *
+        1024 * 1024;
   }
 }
 
@@ -156,7 +193,13 @@ void CommandSystem::add(Command *cmd) {
     group->add(cmd);
   } else {
     m_undo_stack.push_back(cmd);
+    reduce_history();
   }
+}
+
+void CommandSystem::reduce_history() {
+  if (m_undo_stack.size() > kCompressDepth)
+    m_undo_stack[m_undo_stack.size() - 1 - kCompressDepth]->compress();
 
   if (m_max_undo_stack != 0) {
     while (m_undo_stack.size() > m_max_undo_stack) {
@@ -165,6 +208,33 @@ void CommandSystem::add(Command *cmd) {
       delete tmp;
     }
   }
+
+  std::size_t usage = get_memory_usage();
+  if (m_max_undo_memory != 0) {
+    // The last command is always kept
+    while (usage > m_max_undo_memory && m_undo_stack.size() > 1) {
+      Command *tmp = m_undo_stack.front();
+      usage -= tmp->get_size();
+      m_undo_stack.pop_front();
+      delete tmp;
+    }
+  }
+
+  se_dbg_msg(SE_DBG_COMMAND, "undo=%d redo=%d memory=%d KB",
+             static_cast<int>(m_undo_stack.size()),
+             static_cast<int>(m_redo_stack.size()),
+             static_cast<int>(usage / 1024));
+}
+
+std::size_t CommandSystem::get_memory_usage() const {
+  std::size_t size = 0;
+  for (const auto &cmd : m_undo_stack) {
+    size += cmd->get_size();
+  }
+  for (const auto &cmd : m_redo_stack) {
+    size += cmd->get_size();
+  }
+  return size;
 }
 
 void CommandSystem::undo() {
@@ -213,12 +283,24 @@ bool CommandSystem::is_recording() {
   return m_is_recording;
 }
 
+Command *CommandSystem::get_last_command() {
+  if (!m_is_recording || m_undo_stack.empty())
+    return nullptr;
+
+  CommandGroup *group = dynamic_cast<CommandGroup *>(m_undo_stack.back());
+  if (group == nullptr)
+    return nullptr;
+  return group->get_last();
+}
+
 void CommandSystem::finish() {
   if (m_is_recording)
     add(new SubtitleSelectionCommand(&m_document));
 
   m_is_recording = false;
 
+  reduce_history();
+
   m_signal_changed();
 }
 
@@ -33,15 +33,27 @@ class CommandGroup : public Command {
 
   void add(Command *cmd);
 
+  // Return the last command added or NULL.
+  Command *get_last();
+
   void restore();
   void execute();
 
+  std::size_t get_size() const;
+
+  void compress();
+
  protected:
   std::list<Command *> m_stack;
 };
 
+// The undo history is limited by the number of groups (max-undo) and by the
+// memory used (max-undo-memory in MB). The groups older than kCompressDepth
+// are compressed, the oldest groups are removed when a limit is reached.
 class CommandSystem {
  public:
+  static const unsigned int kCompressDepth = 10;
+
   explicit CommandSystem(Document &doc);
 
   virtual ~CommandSystem();
@@ -61,6 +73,11 @@ class CommandSystem {
   // return true if it is recording. You can add your command if it's.
   bool is_recording();
 
+  // Return the last command added to the recording group, a command can
+  // merge the next changes instead of adding a new command.
+  // NULL if it isn't recording.
+  Command *get_last_command();
+
   // Stop recording
   void finish();
 
@@ -76,15 +93,23 @@ class CommandSystem {
   // emit with undo/redo/start/finish
   sigc::signal<void> &signal_changed();
 
+  // Return the memory used by the undo and the redo stacks (bytes).
+  std::size_t get_memory_usage() const;
+
  protected:
   void clearRedo();
 
+  // Compress the old groups and remove the oldest ones until the history
+  // respects the limits.
+  void reduce_history();
+
   void on_config_interface_changed(const Glib::ustring &name,
                                    const Glib::ustring &value);
 
  protected:
   Document &m_document;
   int m_max_undo_stack{10};
+  std::size_t m_max_undo_memory{0};
   bool m_is_recording{false};
   std::deque<Command *> m_undo_stack;
   std::deque<Command *> m_redo_stack;
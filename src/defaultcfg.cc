@@ -80,7 +80,9 @@ void get_default_config(
   config["interface"]["ask-to-save-on-exit"] = "true";
   config["interface"]["create-backup-copy"] = "false";
   config["interface"]["autosave-minutes"] = "10";
+  config["interface"]["autosave-to-recovery"] = "true";
   config["interface"]["max-undo"] = "200";
+  config["interface"]["max-undo-memory"] = "64";
 
   // [encodings]
   config["encodings"]["encodings"] = "ISO-8859-15;UTF-8";
@@ -18,6 +18,10 @@
 // You should have received a copy of the GNU General Public License
 // along with this program. If not, see <http://www.gnu.org/licenses/>.
 
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <set>
 #include "cfg.h"
 #include "encodings.h"
 #include "error.h"
@@ -141,102 +145,432 @@ EncodingInfo *Encodings::get_encodings_info() {
 
 namespace Encoding {
 
+// The detection only converts a sample of the content with each charset.
+static const std::string::size_type sample_max_size = 32 * 1024;
+
+// Return the lines of the content with non-ASCII bytes (the only ones that
+// differ between the charsets), up to sample_max_size.
+// Without non-ASCII bytes, the beginning of the content.
+static std::string build_sample(const gchar *data, gsize size) {
+  std::string sample;
+
+  gsize pos = 0;
+  while (pos < size && sample.size() < sample_max_size) {
+    const gchar *nl =
+        static_cast<const gchar *>(memchr(data + pos, '\n', size - pos));
+    gsize eol = (nl == nullptr) ? size : (nl - data) + 1;
+
+    bool non_ascii = false;
+    for (gsize i = pos; i < eol; ++i) {
+      if (static_cast<unsigned char>(data[i]) >= 0x80) {
+        non_ascii = true;
+        break;
+      }
+    }
+
+    if (non_ascii) {
+      gsize len = eol - pos;
+      // A very long line is cut after an ASCII byte below 0x40, it's never
+      // part of a multibyte character (even the trail bytes of SHIFT_JIS,
+      // BIG5 or GBK are above)
+      if (len > sample_max_size) {
+        len = sample_max_size;
+        while (len > 0 &&
+               static_cast<unsigned char>(data[pos + len - 1]) >= 0x40) {
+          --len;
+        }
+      }
+      sample.append(data + pos, len);
+    }
+    pos = eol;
+  }
+
+  if (sample.empty())
+    sample.assign(data, std::min(size, gsize(sample_max_size)));
+  return sample;
+}
+
+// Return "UTF-16LE" or "UTF-16BE" if the beginning of the content looks like
+// UTF-16 without BOM (the ASCII characters give a zero byte every two bytes),
+// otherwise an empty string.
+static Glib::ustring detect_utf16_without_bom(const gchar *data, gsize size) {
+  size = std::min(size, gsize(sample_max_size)) & ~gsize(1);
+  if (size < 4)
+    return Glib::ustring();
+
+  gsize pairs = size / 2;
+  gsize even_zero = 0, odd_zero = 0;
+  for (gsize i = 0; i < size; i += 2) {
+    if (data[i] == 0)
+      ++even_zero;
+    if (data[i + 1] == 0)
+      ++odd_zero;
+  }
+
+  if (odd_zero > pairs * 4 / 10 && even_zero < pairs / 20)
+    return "UTF-16LE";
+  if (even_zero > pairs * 4 / 10 && odd_zero < pairs / 20)
+    return "UTF-16BE";
+  return Glib::ustring();
+}
+
+// Merge the scripts used together by a language.
+static GUnicodeScript get_script_group(gunichar c) {
+  GUnicodeScript script = g_unichar_get_script(c);
+  if (script == G_UNICODE_SCRIPT_HIRAGANA ||
+      script == G_UNICODE_SCRIPT_KATAKANA)
+    return G_UNICODE_SCRIPT_HAN;
+  return script;
+}
+
+// The most frequent non-ASCII letters of the scripts shared by several
+// charsets, a wrong charset gives more of the others.
+typedef std::map<GUnicodeScript, std::set<gunichar>> FrequentLetters;
+
+static FrequentLetters build_frequent_letters() {
+  FrequentLetters letters;
+
+  const std::pair<GUnicodeScript, const char *> lists[] = {
+      {G_UNICODE_SCRIPT_LATIN,
+       "éèàùìòçİüöäßáíóúñãõêâôîûëïąęćłńśźżčšžřěůýğşıåøæőűœ"},
+      {G_UNICODE_SCRIPT_CYRILLIC, "оеаинтсрвлкмдпуяыьгзбчйіїєґ"},
+      {G_UNICODE_SCRIPT_GREEK, "αοιετνσςκπρυμληωάέίόήύώ"},
+      {G_UNICODE_SCRIPT_HAN,
+       "的一是不了人我在有他这中大来上个们到说和你地出道也时年得就那"
+       "要下以生会自着去之过家学对可她里后小么心多天而能好都然没日于"
+       "起还发成事只作当想看文无开手十用主行方又如前所本见经头面公同"
+       "三已老从动两长知民样现分将外但身些与高意进把法此实回二理美点"
+       "月明其种声全工己话儿者向情部正名定女问力机给等几很业最间新什"
+       "打便位因重被走电四第门相次东政海口使教西再平真听世气信北少关"
+       "并内加化由却代军产入先山五太水万市眼体别处总才场师书比住员九"
+       "笑性通目华报立马命张活难神数件安表原车白应路期叫死常提感金何"
+       "更反合放做系计或司利受光王果亲界及今京务制解各任至清物台象记"
+       "边共风战干接它许八特觉望直服毛林题建南度统色字请交爱让认算论"
+       "百吃义科怎元社术结六功指思非流每青管夫连远资队跟带花快条院变"
+       "联言权往展该领传近留红治决周保达办运武半候七必城父强步完革深"
+       "区即求品士转量空甚众技轻程告江语英基派满式李息写呢识极令黄德"
+       "收脸钱党倒未持取设始版双历越史商千片容研像找友孩站广改议形委"
+       "早房音火际则首单据导影失拿网香似斯专石若兵弟谁校读志飞观争究"
+       "包组造落视济喜离虽坏兴切府居这們來個說時會著過後麼還發對開與"
+       "當點從兩長現將實問機給幾業間們見經頭動學國說話聽風應"}};
+
+  for (const auto &list : lists) {
+    Glib::ustring text(list.second);
+    letters[list.first].insert(text.begin(), text.end());
+  }
+  return letters;
+}
+
+static const FrequentLetters &get_frequent_letters() {
+  static const FrequentLetters letters = build_frequent_letters();
+  return letters;
+}
+
+// Return the weight of a non-ASCII letter, 1 for a frequent letter (or a
+// script without statistics).
+static double get_letter_weight(gunichar c, GUnicodeScript script) {
+  GUnicodeScript real_script = g_unichar_get_script(c);
+  if (real_script == G_UNICODE_SCRIPT_HIRAGANA ||
+      real_script == G_UNICODE_SCRIPT_KATAKANA)
+    return 1;
+
+  const auto &frequent = get_frequent_letters();
+  auto it = frequent.find(script);
+  if (it == frequent.end())
+    return 1;
+  if (it->second.count(c) || it->second.count(g_unichar_tolower(c)))
+    return 1;
+  return (script == G_UNICODE_SCRIPT_HAN) ? 0.5 : 0.25;
+}
+
+// A letter of a script without case and spaces between words (or an other
+// alphabet than latin), it's unusual next to an ASCII letter.
+static bool is_non_latin_letter(gunichar c) {
+  if (c < 0x80 || !g_unichar_isalpha(c))
+    return false;
+  GUnicodeScript script = g_unichar_get_script(c);
+  return script != G_UNICODE_SCRIPT_LATIN &&
+         script != G_UNICODE_SCRIPT_COMMON &&
+         script != G_UNICODE_SCRIPT_INHERITED;
+}
+
+static bool is_symbol(gunichar c) {
+  switch (g_unichar_type(c)) {
+    case G_UNICODE_MATH_SYMBOL:
+    case G_UNICODE_CURRENCY_SYMBOL:
+    case G_UNICODE_MODIFIER_SYMBOL:
+    case G_UNICODE_OTHER_SYMBOL:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Return how much the text (a sample decoded with a charset) looks like a
+// real text, from 1 (every non-ASCII character is plausible) to negative
+// values. Only the non-ASCII characters are scored:
+// - controls, unassigned or private characters are errors
+// - frequent letters are good, others characters a bit less
+// - letters of an other script than the main one are errors
+// - a lowercase followed by an uppercase, two non-ASCII latin letters
+//   side by side, a non-latin letter next to an ASCII letter, a symbol inside
+//   a word and more uppercase than lowercase letters are unusual
+static double score_text(const Glib::ustring &text) {
+  double good = 0, bad = 0;
+  unsigned int count = 0, letters = 0, lower = 0, upper = 0;
+  std::map<GUnicodeScript, unsigned int> scripts;
+
+  gunichar prev = ' ', prev2 = ' ';
+  for (auto it = text.begin(); it != text.end(); ++it) {
+    gunichar c = *it;
+
+    // A symbol inside a word
+    if (g_unichar_isalpha(c) && prev >= 0x80 && is_symbol(prev) &&
+        g_unichar_isalpha(prev2))
+      bad += 1;
+
+    // A non-latin letter next to an ASCII letter
+    if ((c < 0x80 && g_unichar_isalpha(c) && is_non_latin_letter(prev)) ||
+        (prev < 0x80 && g_unichar_isalpha(prev) && is_non_latin_letter(c)))
+      bad += 1;
+
+    if (c >= 0x80) {
+      ++count;
+
+      GUnicodeType type = g_unichar_type(c);
+      if (g_unichar_iscntrl(c) || type == G_UNICODE_UNASSIGNED ||
+          type == G_UNICODE_PRIVATE_USE || type == G_UNICODE_SURROGATE) {
+        bad += 1;
+      } else if (g_unichar_isalpha(c)) {
+        GUnicodeScript script = get_script_group(c);
+        good += get_letter_weight(c, script);
+        if (script != G_UNICODE_SCRIPT_COMMON &&
+            script != G_UNICODE_SCRIPT_INHERITED) {
+          ++letters;
+          ++scripts[script];
+        }
+
+        if (g_unichar_islower(c))
+          ++lower;
+        else if (g_unichar_isupper(c))
+          ++upper;
+
+        if (g_unichar_isupper(c) && g_unichar_islower(prev))
+          bad += 0.5;
+        if (script == G_UNICODE_SCRIPT_LATIN && prev >= 0x80 &&
+            g_unichar_isalpha(prev) &&
+            g_unichar_get_script(prev) == G_UNICODE_SCRIPT_LATIN)
+          bad += 0.5;
+      } else {
+        good += 0.5;
+      }
+    }
+    prev2 = prev;
+    prev = c;
+  }
+
+  if (count == 0)
+    return 1;
+
+  unsigned int main_script = 0;
+  for (const auto &s : scripts) {
+    main_script = std::max(main_script, s.second);
+  }
+  bad += letters - main_script;
+
+  if (upper > lower)
+    bad += 0.5 * (upper - lower);
+
+  return (good - bad) / count;
+}
+
+// Return the candidate charsets sorted by score (the best first). The first
+// user encoding preference whose score is close to the best is moved to the
+// front, a statistical difference on a sample should not override it.
+static std::vector<std::pair<double, Glib::ustring>> score_charsets(
+    const gchar *data, gsize size) {
+  // Tolerance on the score (per non-ASCII character) for the preferences
+  const double preferred_tolerance = 0.1;
+
+  std::vector<Glib::ustring> preferred =
+      cfg::get_string_list("encodings", "encodings");
+  std::vector<Glib::ustring> charsets = preferred;
+  for (unsigned int i = 0; encodings_info[i].name != NULL; ++i) {
+    charsets.push_back(encodings_info[i].charset);
+  }
+
+  std::string sample = build_sample(data, size);
+
+  std::vector<std::pair<double, Glib::ustring>> scores;
+  std::vector<Glib::ustring> done;
+  for (const auto &charset : charsets) {
+    // Unicode charsets are already checked without statistics
+    if (charset.find("UTF") == 0 || charset.find("UCS") == 0)
+      continue;
+    if (std::find(done.begin(), done.end(), charset) != done.end())
+      continue;
+    done.push_back(charset);
+
+    try {
+      Glib::ustring text = Glib::convert(sample, "UTF-8", charset);
+      if (!text.validate())
+        continue;
+
+      double score = score_text(text);
+      se_dbg_msg(SE_DBG_UTILITY, "%s score %.3f", charset.c_str(), score);
+      scores.push_back(std::make_pair(score, charset));
+    } catch (const Glib::ConvertError &) {
+      // invalid, try with the next...
+    }
+  }
+
+  std::stable_sort(scores.begin(), scores.end(),
+                   [](const std::pair<double, Glib::ustring> &a,
+                      const std::pair<double, Glib::ustring> &b) {
+                     return a.first > b.first;
+                   });
+
+  if (scores.empty())
+    return scores;
+
+  const double best = scores.front().first;
+  for (const auto &charset : preferred) {
+    auto it = std::find_if(
+        scores.begin(), scores.end(),
+        [&charset](const std::pair<double, Glib::ustring> &s) {
+          return s.second == charset;
+        });
+    if (it == scores.end() || it->first < best - preferred_tolerance)
+      continue;
+
+    se_dbg_msg(SE_DBG_UTILITY, "Prefer %s (score %.3f, best %.3f)",
+               charset.c_str(), it->first, best);
+    std::rotate(scores.begin(), it, it + 1);
+    break;
+  }
+  return scores;
+}
+
 // Trying to convert from charset to UTF-8.
 // Return utf8 string or throw EncodingConvertError exception.
 Glib::ustring convert_to_utf8_from_charset(const std::string &content,
                                            const Glib::ustring &charset) {
+  return convert_to_utf8_from_charset(content.data(), content.size(), charset);
+}
+
+Glib::ustring convert_to_utf8_from_charset(const gchar *data, gsize size,
+                                           const Glib::ustring &charset) {
   se_dbg_msg(SE_DBG_UTILITY, "Trying to convert from %s to UTF-8",
              charset.c_str());
 
   // Only if it's UTF-8 to UTF-8
   if (charset == "UTF-8") {
-    if (Glib::ustring(content).validate() == false)
+    if (g_utf8_validate(data, size, NULL) == FALSE)
       throw EncodingConvertError(_("It's not valid UTF-8."));
 
-    return content;
-  } else {
-    try {
-      Glib::ustring utf8_content = Glib::convert(content, "UTF-8", charset);
-
-      if (!utf8_content.validate() || utf8_content.empty())
-        throw EncodingConvertError(build_message(
-            _("Couldn't convert from %s to UTF-8"), charset.c_str()));
+    return Glib::ustring(data, data + size);
+  }
 
-      return utf8_content;
-    } catch (const Glib::ConvertError &ex) {
-      se_dbg_msg(SE_DBG_UTILITY, "Glib::ConvertError: %s", ex.what().c_str());
-      throw EncodingConvertError(build_message(
-          _("Couldn't convert from %s to UTF-8"), charset.c_str()));
-    } catch (...) {
-      se_dbg_msg(SE_DBG_UTILITY, "Unknow error");
-      throw EncodingConvertError(build_message(
-          _("Couldn't convert from %s to UTF-8"), charset.c_str()));
-    }
+  GError *error = NULL;
+  gsize bytes_written = 0;
+  gchar *converted = g_convert(data, size, "UTF-8", charset.c_str(), NULL,
+                               &bytes_written, &error);
+  if (converted == NULL) {
+    se_dbg_msg(SE_DBG_UTILITY, "g_convert error: %s",
+               error ? error->message : "unknow");
+    if (error)
+      g_error_free(error);
+    throw EncodingConvertError(build_message(
+        _("Couldn't convert from %s to UTF-8"), charset.c_str()));
   }
+
+  bool valid = bytes_written > 0 &&
+               g_utf8_validate(converted, bytes_written, NULL) == TRUE;
+
+  Glib::ustring utf8_content;
+  if (valid)
+    utf8_content = Glib::ustring(converted, converted + bytes_written);
+  g_free(converted);
+
+  if (!valid)
+    throw EncodingConvertError(build_message(
+        _("Couldn't convert from %s to UTF-8"), charset.c_str()));
+  return utf8_content;
 }
 
 // Trying to autodetect the charset and convert to UTF-8.
 // 3 steps:
-// - Try UTF-8
-// - Try with user encoding preferences
-// - Try with all encodings
+// - Try UTF-16 (BOM) and UTF-8
+// - Try UTF-16 without BOM (zero bytes pattern)
+// - Score the user encoding preferences and all encodings on a sample of the
+//   content, then convert with the best one
 // Return utf8 string and sets charset found
 // or throw EncodingConvertError exception.
 Glib::ustring convert_to_utf8(const std::string &content,
                               Glib::ustring &charset) {
-  if (content.empty())
-    return Glib::ustring();
-
-  // First check if it's not UTF-8.
-  se_dbg_msg(SE_DBG_UTILITY, "Trying to UTF-8...");
+  return convert_to_utf8(content.data(), content.size(), charset);
+}
 
-  try {
-    Glib::ustring utf8_content =
-        Encoding::convert_to_utf8_from_charset(content, "UTF-8");
+Glib::ustring convert_to_utf8(const gchar *data, gsize size,
+                              Glib::ustring &charset) {
+  if (size == 0)
+    return Glib::ustring();
 
-    if (utf8_content.validate() && utf8_content.empty() == false) {
-      charset = "UTF-8";
-      return content;
+  // A UTF-16 BOM
+  if (size >= 2 && ((data[0] == '\xFF' && data[1] == '\xFE') ||
+                    (data[0] == '\xFE' && data[1] == '\xFF'))) {
+    se_dbg_msg(SE_DBG_UTILITY, "UTF-16 BOM found");
+    try {
+      Glib::ustring utf8_content =
+          Encoding::convert_to_utf8_from_charset(data, size, "UTF-16");
+      charset = "UTF-16";
+      return utf8_content;
+    } catch (const EncodingConvertError &ex) {
+      se_dbg_msg(SE_DBG_UTILITY, "EncodingConvertError: %s", ex.what());
     }
-  } catch (const EncodingConvertError &ex) {
-    se_dbg_msg(SE_DBG_UTILITY, "EncodingConvertError: %s", ex.what());
   }
 
-  // Try to automatically dectect the encoding
-
-  // With the user charset preferences...
-  se_dbg_msg(SE_DBG_UTILITY, "Trying with user encodings preferences...");
+  // First check if it's not UTF-8 (with or without BOM).
+  se_dbg_msg(SE_DBG_UTILITY, "Trying to UTF-8...");
 
-  auto user_encodings = cfg::get_string_list("encodings", "encodings");
+  if (g_utf8_validate(data, size, NULL)) {
+    charset = "UTF-8";
+    return Glib::ustring(data, data + size);
+  }
 
-  for (const auto &enc : user_encodings) {
+  Glib::ustring utf16 = detect_utf16_without_bom(data, size);
+  if (!utf16.empty()) {
+    se_dbg_msg(SE_DBG_UTILITY, "Looks like %s", utf16.c_str());
     try {
-      Glib::ustring utf8_content = convert_to_utf8_from_charset(content, enc);
-
-      if (utf8_content.validate() && utf8_content.empty() == false) {
-        charset = enc;
-        return utf8_content;
-      }
+      Glib::ustring utf8_content =
+          Encoding::convert_to_utf8_from_charset(data, size, utf16);
+      charset = utf16;
+      return utf8_content;
     } catch (const EncodingConvertError &ex) {
-      // invalid, try with the next...
       se_dbg_msg(SE_DBG_UTILITY, "EncodingConvertError: %s", ex.what());
     }
   }
 
-  // With all charset...
-  se_dbg_msg(SE_DBG_UTILITY, "Trying with all encodings...");
+  // Try to automatically dectect the encoding from a sample, only the best
+  // charset converts the whole content (the next ones if it fails)
+  se_dbg_msg(SE_DBG_UTILITY, "Scoring the encodings...");
 
-  for (unsigned int i = 0; encodings_info[i].name != NULL; ++i) {
-    Glib::ustring it = encodings_info[i].charset;
+  auto scores = score_charsets(data, size);
 
+  for (unsigned int i = 0; i < scores.size(); ++i) {
+    const Glib::ustring &enc = scores[i].second;
     try {
       Glib::ustring utf8_content =
-          Encoding::convert_to_utf8_from_charset(content, it);
-
-      if (utf8_content.validate() && utf8_content.empty() == false) {
-        charset = it;
-        return utf8_content;
-      }
+          convert_to_utf8_from_charset(data, size, enc);
+
+      double confidence = std::max(0.0, std::min(1.0, scores[i].first));
+      se_dbg_msg(SE_DBG_UTILITY,
+                 "Detected %s with confidence %.2f (next: %s %.2f)",
+                 enc.c_str(), confidence,
+                 (i + 1 < scores.size()) ? scores[i + 1].second.c_str() : "-",
+                 (i + 1 < scores.size()) ? scores[i + 1].first : 0.0);
+      charset = enc;
+      return utf8_content;
     } catch (const EncodingConvertError &ex) {
       // invalid, try with the next...
       se_dbg_msg(SE_DBG_UTILITY, "EncodingConvertError: %s", ex.what());
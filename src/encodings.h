@@ -52,16 +52,27 @@ namespace Encoding {
 Glib::ustring convert_to_utf8_from_charset(const std::string &content,
                                            const Glib::ustring &charset);
 
+// Same from a buffer (size bytes), the data isn't copied before the
+// conversion.
+Glib::ustring convert_to_utf8_from_charset(const gchar *data, gsize size,
+                                           const Glib::ustring &charset);
+
 // Trying to autodetect the charset and convert to UTF-8.
 // 3 steps:
-// - Try UTF-8
-// - Try with user encoding preferences
-// - Try with all encodings
+// - Try UTF-16 (BOM) and UTF-8
+// - Try UTF-16 without BOM (zero bytes pattern)
+// - Score the user encoding preferences and all encodings on a sample of the
+//   content, then convert with the best one
 // Return utf8 string and sets charset found
 // or throw EncodingConvertError exception.
 Glib::ustring convert_to_utf8(const std::string &content,
                               Glib::ustring &charset);
 
+// Same from a buffer (size bytes), the data isn't copied before the
+// conversion.
+Glib::ustring convert_to_utf8(const gchar *data, gsize size,
+                              Glib::ustring &charset);
+
 // Convert the UTF-8 text to the charset.
 // Throw EncodingConvertError exception.
 std::string convert_from_utf8_to_charset(const Glib::ustring &utf8_content,
@@ -24,8 +24,95 @@
 #include "error.h"
 #include "filereader.h"
 
+// Return the size of the head without the last character if it's cut.
+// The head is UTF-16 if it starts with a BOM or has zero bytes (the ASCII
+// characters), only complete code units (and surrogate pairs) are kept.
+// Otherwise an incomplete UTF-8 sequence at the end is removed, for an 8-bit
+// charset it removes at most three bytes of the sample.
+static gsize complete_head_size(const std::string &head) {
+  gsize size = head.size();
+  const guchar *data = reinterpret_cast<const guchar *>(head.data());
+
+  bool bom_le = size >= 2 && data[0] == 0xFF && data[1] == 0xFE;
+  bool bom_be = size >= 2 && data[0] == 0xFE && data[1] == 0xFF;
+  gsize even_zero = 0, odd_zero = 0;
+  for (gsize i = 0; i < size; ++i) {
+    if (data[i] == 0 && i % 2)
+      ++odd_zero;
+    else if (data[i] == 0)
+      ++even_zero;
+  }
+
+  if (bom_le || bom_be || even_zero + odd_zero > 0) {
+    size &= ~gsize(1);
+    if (size < 2)
+      return size;
+    // The ASCII characters have their zero byte after (LE) or before (BE)
+    bool le = bom_le || (!bom_be && odd_zero >= even_zero);
+    guint unit = le ? (data[size - 2] | (data[size - 1] << 8))
+                    : ((data[size - 2] << 8) | data[size - 1]);
+    // A high surrogate without its pair
+    if (unit >= 0xD800 && unit <= 0xDBFF)
+      size -= 2;
+    return size;
+  }
+
+  // The lead byte of the last sequence, at most 3 bytes before the end
+  for (gsize n = 1; n <= 4 && n <= size; ++n) {
+    guchar c = data[size - n];
+    if ((c & 0xC0) == 0x80)
+      continue;
+    gsize length = (c >= 0xF0) ? 4 : (c >= 0xE0) ? 3 : (c >= 0xC0) ? 2 : 1;
+    return (length > n) ? size - n : size;
+  }
+  return size;
+}
+
+// Read only the first max_size bytes of the file (used to detect the format
+// of the file without loading it).
+static std::string read_head_of_file(const Glib::RefPtr<Gio::File> &file,
+                                     gsize max_size) {
+  std::string content(max_size, '\0');
+
+  Glib::RefPtr<Gio::FileInputStream> stream = file->read();
+  gsize total = 0;
+  while (total < max_size) {
+    gssize bytes_read = stream->read(&content[total], max_size - total);
+    if (bytes_read <= 0)
+      break;
+    total += bytes_read;
+  }
+  stream->close();
+  content.resize(total);
+
+  // The head can be cut in the middle of a character
+  if (total == max_size)
+    content.resize(complete_head_size(content));
+  return content;
+}
+
+// Convert the data to UTF-8 with the charset or the charset detected.
+static void convert_contents(const gchar *data, gsize size,
+                             const Glib::ustring &charset,
+                             Glib::ustring &utf8_contents,
+                             Glib::ustring &charset_contents) {
+  Glib::ustring converted;
+  if (charset.empty()) {
+    // Try to autodetect
+    converted = Encoding::convert_to_utf8(data, size, charset_contents);
+  } else {
+    // try with charset
+    converted = Encoding::convert_to_utf8_from_charset(data, size, charset);
+  }
+  // The result is moved, not copied
+  utf8_contents.swap(converted);
+}
+
 // Reads an entire file into a string, with good error checking.
 // If charset is empty, auto detection is try.
+// With max_data_size, only the beginning of the file is read. A local file is
+// mapped in memory and converted from there, the contents is never copied
+// before the conversion.
 bool get_contents_from_file(const Glib::ustring &uri,
                             const Glib::ustring &charset,
                             Glib::ustring &utf8_contents,
@@ -35,13 +122,41 @@ bool get_contents_from_file(const Glib::ustring &uri,
              uri.c_str(), charset.c_str());
 
   try {
-    Glib::ustring content;
+    Glib::RefPtr<Gio::File> file = Gio::File::create_for_uri(uri);
+    if (!file)
+      throw IOFileError(_("Couldn't open the file."));
 
-    {
-      Glib::RefPtr<Gio::File> file = Gio::File::create_for_uri(uri);
-      if (!file)
-        throw IOFileError(_("Couldn't open the file."));
+    std::string path = file->get_path();
 
+    if (max_data_size > 0) {
+      std::string content;
+      try {
+        content = read_head_of_file(file, max_data_size);
+      } catch (const Glib::Error &) {
+        throw IOFileError(_("Couldn't read the contents of the file."));
+      }
+      convert_contents(content.data(), content.size(), charset, utf8_contents,
+                       charset_contents);
+    } else if (!path.empty()) {
+      GError *error = NULL;
+      GMappedFile *mapped = g_mapped_file_new(path.c_str(), FALSE, &error);
+      if (mapped == NULL) {
+        se_dbg_msg(SE_DBG_IO, "Could not map the file: %s", error->message);
+        g_error_free(error);
+        throw IOFileError(_("Couldn't read the contents of the file."));
+      }
+
+      try {
+        convert_contents(g_mapped_file_get_contents(mapped),
+                         g_mapped_file_get_length(mapped), charset,
+                         utf8_contents, charset_contents);
+      } catch (...) {
+        g_mapped_file_unref(mapped);
+        throw;
+      }
+      g_mapped_file_unref(mapped);
+    } else {
+      // Not a local file (gvfs), the whole contents is loaded
       gchar *raw = NULL;
       gsize bytes_read = 0;
       std::string e_tag;
@@ -49,34 +164,21 @@ bool get_contents_from_file(const Glib::ustring &uri,
       if (file->load_contents(raw, bytes_read, e_tag) == false)
         throw IOFileError(_("Couldn't read the contents of the file."));
 
-      content = std::string(raw, bytes_read);
-
+      try {
+        convert_contents(raw, bytes_read, charset, utf8_contents,
+                         charset_contents);
+      } catch (...) {
+        g_free(raw);
+        throw;
+      }
       g_free(raw);
     }
 
-    if (max_data_size > 0) {
-      if (content.size() > max_data_size)
-        content = content.substr(0, max_data_size);
-    }
-
-    if (charset.empty()) {
-      // Try to autodetect
-      utf8_contents = Encoding::convert_to_utf8(content, charset_contents);
-
-      se_dbg_msg(SE_DBG_IO,
-                 "Success to get the contents of the file %s with %s charset",
-                 uri.c_str(), charset_contents.c_str());
-
-      return true;
-    } else {
-      // try with charset
-      utf8_contents = Encoding::convert_to_utf8_from_charset(content, charset);
-
-      se_dbg_msg(SE_DBG_IO,
-                 "Success to get the contents of the file %s with %s charset",
-                 uri.c_str(), charset.c_str());
-      return true;
-    }
+    se_dbg_msg(SE_DBG_IO,
+               "Success to get the contents of the file %s with %s charset",
+               uri.c_str(),
+               charset.empty() ? charset_contents.c_str() : charset.c_str());
+    return true;
   } catch (const std::exception &ex) {
     throw IOFileError(ex.what());
   }
@@ -24,6 +24,12 @@
 #include "error.h"
 #include "reader.h"
 
+// Return a copy of the line.
+Glib::ustring Reader::LineView::str() const {
+  // Use the iterators constructor, only a raw copy of the bytes
+  return Glib::ustring(data, data + size);
+}
+
 // Constructor.
 Reader::Reader(const Glib::ustring &data) : m_data(data) {
 }
@@ -37,44 +43,55 @@ const Glib::ustring &Reader::get_data() const {
 }
 
 // Return the newline detected of the file.
+// Any CRLF means "Windows", a CR alone "Macintosh" and "Unix" by default.
 Glib::ustring Reader::get_newline() {
-  Glib::ustring newline;
-
-  if (Glib::Regex::match_simple("\\r\\n", m_data))
-    newline = "Windows";
-  else if (Glib::Regex::match_simple("\\r", m_data))
+  Glib::ustring newline = "Unix";
+
+  const std::string &raw = m_data.raw();
+  const gchar *data = raw.data();
+  const gsize size = raw.size();
+
+  for (gsize i = 0; i < size; ++i) {
+    if (data[i] != '\r')
+      continue;
+    if (i + 1 < size && data[i + 1] == '\n') {
+      newline = "Windows";
+      break;
+    }
     newline = "Macintosh";
-  else if (Glib::Regex::match_simple("\\n", m_data))
-    newline = "Unix";
-  else
-    newline = "Unix";
+  }
 
   se_dbg_msg(SE_DBG_IO, "newline=%s", newline.c_str());
 
-  // default
   return newline;
 }
 
 // Get the next line of the file without newline character (CR, LF or CRLF).
 bool Reader::getline(Glib::ustring &line) {
-  initialize_lines();
-
-  if (m_iter == m_lines.end()) {
-    se_dbg_msg(SE_DBG_IO, "EOF");
+  LineView view;
+  if (!getline(view))
     return false;
-  }
 
-  line = *m_iter;
-  ++m_iter;
+  line = view.str();
 
   se_dbg_msg(SE_DBG_IO, "\"%s\"", line.c_str());
 
   return true;
 }
 
+// Get the next line of the file without newline character (CR, LF or CRLF)
+// and without copying it.
+bool Reader::getline(LineView &line) {
+  if (!scan_line(m_pos, line)) {
+    se_dbg_msg(SE_DBG_IO, "EOF");
+    return false;
+  }
+  return true;
+}
+
 // Return all lines detected of the file, without newline character (CR, LF or
 // CRLF).
-std::vector<Glib::ustring> Reader::get_lines() {
+const std::vector<Glib::ustring> &Reader::get_lines() {
   initialize_lines();
 
   return m_lines;
@@ -88,7 +105,61 @@ void Reader::initialize_lines() {
 
   se_dbg_msg(SE_DBG_IO, "split lines...");
 
-  m_lines = Glib::Regex::split_simple("\\R", m_data);
-  m_iter = m_lines.begin();
+  gsize pos = 0;
+  LineView view;
+  while (scan_line(pos, view)) {
+    m_lines.push_back(view.str());
+  }
   m_lines_init = true;
 }
+
+// Return the size of the newline sequence at 'pos' or 0.
+// Like the regex "\R": CRLF, LF, VT, FF, CR, NEL (U+0085), LS (U+2028) and
+// PS (U+2029).
+static gsize newline_size(const gchar *data, gsize pos, gsize size) {
+  switch (static_cast<unsigned char>(data[pos])) {
+    case '\r':
+      return (pos + 1 < size && data[pos + 1] == '\n') ? 2 : 1;
+    case '\n':
+    case '\v':
+    case '\f':
+      return 1;
+    case 0xC2:
+      return (pos + 1 < size && data[pos + 1] == '\x85') ? 2 : 0;
+    case 0xE2:
+      return (pos + 2 < size && data[pos + 1] == '\x80' &&
+              (data[pos + 2] == '\xA8' || data[pos + 2] == '\xA9'))
+                 ? 3
+                 : 0;
+    default:
+      return 0;
+  }
+}
+
+// Like the old split with the regex "\R", an empty line is returned after the
+// last newline character.
+bool Reader::scan_line(gsize &pos, LineView &line) const {
+  const std::string &raw = m_data.raw();
+  const gsize size = raw.size();
+
+  if (pos > size || size == 0)
+    return false;
+
+  const gchar *data = raw.data();
+  gsize end = pos;
+  gsize newline = 0;
+  while (end < size && (newline = newline_size(data, end, size)) == 0) {
+    ++end;
+  }
+
+  line.data = data + pos;
+  line.size = end - pos;
+
+  if (end == size) {
+    // no newline, this is the last line
+    pos = size + 1;
+  } else {
+    pos = end + newline;
+  }
+  return true;
+}
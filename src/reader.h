@@ -26,6 +26,17 @@
 // Return lines without character of newline (CR,LF or CRLF)
 class Reader {
  public:
+  // A line of the data without newline character (CR, LF or CRLF).
+  // The line is not copied, it points directly into the data of the reader
+  // and is only valid as long as the reader is alive and unchanged.
+  struct LineView {
+    const gchar *data{nullptr};
+    gsize size{0};
+
+    // Return a copy of the line.
+    Glib::ustring str() const;
+  };
+
   // Constructor.
   explicit Reader(const Glib::ustring &data = Glib::ustring());
 
@@ -41,17 +52,28 @@ class Reader {
   // Get the next line of the file without newline character (CR, LF or CRLF).
   bool getline(Glib::ustring &line);
 
+  // Get the next line of the file without newline character (CR, LF or CRLF)
+  // and without copying it.
+  bool getline(LineView &line);
+
   // Return all lines detected of the file, without newline character (CR, LF or
   // CRLF).
-  std::vector<Glib::ustring> get_lines();
+  const std::vector<Glib::ustring> &get_lines();
 
  private:
   // Split the data to separate lines.
   void initialize_lines();
 
+  // Scan the data from 'pos' to the next newline (CR, LF, CRLF, VT, FF, NEL,
+  // LS or PS like the regex "\R").
+  // Fill the line and move 'pos' after the newline.
+  // Return false at the end of the data.
+  bool scan_line(gsize &pos, LineView &line) const;
+
  protected:
   Glib::ustring m_data;
+  // Position of the next line returned by getline
+  gsize m_pos{0};
   bool m_lines_init{false};
-  std::vector<Glib::ustring>::const_iterator m_iter;
   std::vector<Glib::ustring> m_lines;
 };
@@ -24,36 +24,239 @@
 #include "subtitle.h"
 #include "utility.h"
 
+// Record the changes of the subtitles made while a command is recording.
+//
+// The consecutive changes are merged in the same command, each change is a
+// small typed record (row, field, old and new values) stored in a
+// contiguous array, the texts are stored in a single buffer. A pass over the
+// whole document creates one command instead of one command (with its
+// strings) by change.
 class SubtitleCommand : public Command {
  public:
-  SubtitleCommand(const Subtitle &sub, const Glib::ustring &name_value,
-                  const Glib::ustring &new_value)
-      : Command(sub.m_document, "Subtitle edited " + name_value),
-        m_path(sub.m_path),
-        m_name_value(name_value),
-        m_old(sub.get(name_value)),
-        m_new(new_value) {
-    se_dbg_msg(SE_DBG_APP, "name=<%s> old=<%s> new=<%s>", m_name_value.c_str(),
-               m_old.c_str(), m_new.c_str());
+  static const std::size_t kMinCompressSize = 4096;
+
+  explicit SubtitleCommand(Document *doc) : Command(doc, "Subtitle edited") {
   }
 
-  void execute() {
-    Subtitle subtitle(document(), m_path);
+  // Return the command of the recording group where the changes can be
+  // merged. A new command is added if the last one isn't a SubtitleCommand.
+  static SubtitleCommand *get(Document *doc) {
+    SubtitleCommand *cmd = dynamic_cast<SubtitleCommand *>(
+        doc->get_command_system().get_last_command());
+    if (cmd == nullptr) {
+      cmd = new SubtitleCommand(doc);
+      doc->add_command(cmd);
+    }
+    return cmd;
+  }
+
+  void add(const Subtitle &sub, Subtitle::Field field, long value) {
+    Record &r = add_record(sub, field);
+    r.old_value.number = get_number(sub, field);
+    r.new_value.number = value;
+  }
 
-    subtitle.set(m_name_value, m_new);
+  void add(const Subtitle &sub, Subtitle::Field field, double value) {
+    Record &r = add_record(sub, field);
+    r.old_value.real = sub.get_characters_per_second_text();
+    r.new_value.real = value;
+  }
+
+  void add(const Subtitle &sub, Subtitle::Field field,
+           const Glib::ustring &value) {
+    Record &r = add_record(sub, field);
+    r.old_value.text = add_text(get_string(sub, field));
+    r.new_value.text = add_text(value);
+  }
+
+  void execute() {
+    if (!uncompress())
+      return;
+    for (const auto &r : m_records) {
+      apply(r, r.new_value);
+    }
   }
 
   void restore() {
-    Subtitle subtitle(document(), m_path);
+    if (!uncompress())
+      return;
+    for (auto it = m_records.rbegin(); it != m_records.rend(); ++it) {
+      apply(*it, it->old_value);
+    }
+  }
+
+  std::size_t get_size() const {
+    return Command::get_size() + sizeof(*this) - sizeof(Command) +
+           m_records.capacity() * sizeof(Record) + m_texts.capacity() +
+           m_compressed.capacity();
+  }
+
+  // Only the texts are compressed, the records are small.
+  void compress() {
+    m_records.shrink_to_fit();
+    if (m_texts.size() < kMinCompressSize)
+      return;
+
+    if (utility::compress(m_texts, m_compressed)) {
+      std::string().swap(m_texts);
+      m_compressed.shrink_to_fit();
+    } else {
+      m_compressed.clear();
+    }
+  }
+
+ protected:
+  struct Text {
+    guint offset;
+    guint length;
+  };
+
+  union Value {
+    long number;
+    double real;
+    Text text;
+  };
+
+  struct Record {
+    guint row;
+    Subtitle::Field field;
+    Value old_value;
+    Value new_value;
+  };
+
+  Record &add_record(const Subtitle &sub, Subtitle::Field field) {
+    m_records.push_back(Record());
+    Record &r = m_records.back();
+    r.row = get_document_subtitle_model()->get_path(sub.m_iter)[0];
+    r.field = field;
+    se_dbg_msg(SE_DBG_APP, "row=%d field=%d", r.row, field);
+    return r;
+  }
+
+  // Return false if the texts can't be uncompressed, the command is then
+  // unusable and the compressed data is kept.
+  bool uncompress() {
+    if (m_compressed.empty())
+      return true;
+
+    std::string texts;
+    if (!utility::uncompress(m_compressed, texts)) {
+      g_warning("Could not uncompress the command '%s'",
+                description().c_str());
+      return false;
+    }
+    m_texts.swap(texts);
+    std::string().swap(m_compressed);
+    return true;
+  }
+
+  Text add_text(const Glib::ustring &text) {
+    Text t = {static_cast<guint>(m_texts.size()),
+              static_cast<guint>(text.bytes())};
+    m_texts.append(text.raw());
+    return t;
+  }
+
+  static long get_number(const Subtitle &sub, Subtitle::Field field) {
+    switch (field) {
+      case Subtitle::FIELD_START:
+        return sub.get_start_value();
+      case Subtitle::FIELD_END:
+        return sub.get_end_value();
+      case Subtitle::FIELD_DURATION:
+        return sub.get_duration_value();
+      default:
+        return 0;
+    }
+  }
+
+  static Glib::ustring get_string(const Subtitle &sub,
+                                  Subtitle::Field field) {
+    switch (field) {
+      case Subtitle::FIELD_LAYER:
+        return sub.get_layer();
+      case Subtitle::FIELD_STYLE:
+        return sub.get_style();
+      case Subtitle::FIELD_NAME:
+        return sub.get_name();
+      case Subtitle::FIELD_MARGIN_L:
+        return sub.get_margin_l();
+      case Subtitle::FIELD_MARGIN_R:
+        return sub.get_margin_r();
+      case Subtitle::FIELD_MARGIN_V:
+        return sub.get_margin_v();
+      case Subtitle::FIELD_EFFECT:
+        return sub.get_effect();
+      case Subtitle::FIELD_TEXT:
+        return sub.get_text();
+      case Subtitle::FIELD_TRANSLATION:
+        return sub.get_translation();
+      case Subtitle::FIELD_NOTE:
+        return sub.get_note();
+      default:
+        return Glib::ustring();
+    }
+  }
 
-    subtitle.set(m_name_value, m_old);
+  void apply(const Record &r, const Value &value) {
+    Gtk::TreeIter iter = get_document_subtitle_model()->children()[r.row];
+    Subtitle sub(document(), iter);
+
+    Glib::ustring text;
+    if (r.field >= Subtitle::FIELD_LAYER)
+      text = m_texts.substr(value.text.offset, value.text.length);
+
+    switch (r.field) {
+      case Subtitle::FIELD_START:
+        sub.set_start_value(value.number);
+        break;
+      case Subtitle::FIELD_END:
+        sub.set_end_value(value.number);
+        break;
+      case Subtitle::FIELD_DURATION:
+        sub.set_duration_value(value.number);
+        break;
+      case Subtitle::FIELD_CHARACTERS_PER_SECOND_TEXT:
+        sub.set_characters_per_second_text(value.real);
+        break;
+      case Subtitle::FIELD_LAYER:
+        sub.set_layer(text);
+        break;
+      case Subtitle::FIELD_STYLE:
+        sub.set_style(text);
+        break;
+      case Subtitle::FIELD_NAME:
+        sub.set_name(text);
+        break;
+      case Subtitle::FIELD_MARGIN_L:
+        sub.set_margin_l(text);
+        break;
+      case Subtitle::FIELD_MARGIN_R:
+        sub.set_margin_r(text);
+        break;
+      case Subtitle::FIELD_MARGIN_V:
+        sub.set_margin_v(text);
+        break;
+      case Subtitle::FIELD_EFFECT:
+        sub.set_effect(text);
+        break;
+      case Subtitle::FIELD_TEXT:
+        sub.set_text(text);
+        break;
+      case Subtitle::FIELD_TRANSLATION:
+        sub.set_translation(text);
+        break;
+      case Subtitle::FIELD_NOTE:
+        sub.set_note(text);
+        break;
+    }
   }
 
  protected:
-  const Glib::ustring m_path;
-  const Glib::ustring m_name_value;
-  const Glib::ustring m_old;
-  const Glib::ustring m_new;
+  std::vector<Record> m_records;
+  std::string m_texts;
+  // The texts when the command is compressed
+  std::string m_compressed;
 };
 
 // static
@@ -63,23 +266,31 @@ Subtitle::Subtitle() {
 }
 
 Subtitle::Subtitle(Document *doc, const Glib::ustring &path)
-    : m_document(doc), m_path(path) {
+    : m_document(doc) {
   m_iter = doc->get_subtitle_model()->get_iter(path);
 }
 
+// Only the iterator is kept, the path is resolved when it's needed.
 Subtitle::Subtitle(Document *doc, const Gtk::TreeIter &it)
     : m_document(doc), m_iter(it) {
-  if (it)
-    m_path = doc->get_subtitle_model()->get_string(it);
 }
 
 Subtitle::~Subtitle() {
 }
 
-void Subtitle::push_command(const Glib::ustring &name,
-                            const Glib::ustring &value) {
+void Subtitle::push_command(Field field, long value) {
   if (m_document->is_recording())
-    m_document->add_command(new SubtitleCommand(*this, name, value));
+    SubtitleCommand::get(m_document)->add(*this, field, value);
+}
+
+void Subtitle::push_command(Field field, double value) {
+  if (m_document->is_recording())
+    SubtitleCommand::get(m_document)->add(*this, field, value);
+}
+
+void Subtitle::push_command(Field field, const Glib::ustring &value) {
+  if (m_document->is_recording())
+    SubtitleCommand::get(m_document)->add(*this, field, value);
 }
 
 Subtitle::operator bool() const {
@@ -98,32 +309,25 @@ bool Subtitle::operator!=(const Subtitle &sub) const {
 
 Subtitle &Subtitle::operator++() {
   ++m_iter;
-
-  m_path = (m_iter) ? m_document->get_subtitle_model()->get_string(m_iter) : "";
-
   return *this;
 }
 
 Subtitle &Subtitle::operator--() {
   --m_iter;
-
-  m_path = (m_iter) ? m_document->get_subtitle_model()->get_string(m_iter) : "";
-
   return *this;
 }
 
-// Set the number of subtitle.
-void Subtitle::set_num(unsigned int num) {
-  (*m_iter)[column.num] = num;
+// Return the number of subtitle, from the position of the row.
+unsigned int Subtitle::get_num() const {
+  return get_model()->get_num(m_iter);
 }
 
-// Return the number of subtitle.
-unsigned int Subtitle::get_num() const {
-  return (*m_iter)[column.num];
+Glib::RefPtr<SubtitleModel> Subtitle::get_model() const {
+  return m_document->get_subtitle_model();
 }
 
 void Subtitle::set_layer(const Glib::ustring &layer) {
-  push_command("layer", layer);
+  push_command(FIELD_LAYER, layer);
 
   (*m_iter)[column.layer] = layer;
 }
@@ -292,14 +496,16 @@ bool Subtitle::check_gap_after(long mingap) {
 
 // Set the start value in the subtitle time mode. (FRAME or TIME)
 void Subtitle::set_start_value(const long &value) {
-  push_command("start", to_string(value));
+  push_command(FIELD_START, value);
+  get_model()->update_start_value(get_num() - 1, value);
   (*m_iter)[column.start_value] = value;
   update_gap_before();
 }
 
 // Set the end value in the subtitle time mode. (FRAME or TIME)
 void Subtitle::set_end_value(const long &value) {
-  push_command("end", to_string(value));
+  push_command(FIELD_END, value);
+  get_model()->update_end_value(get_num() - 1, value);
   (*m_iter)[column.end_value] = value;
   update_gap_after();
 }
@@ -324,8 +530,9 @@ long Subtitle::get_end_value() const {
 
 // Set the duration value in the subtitle time mode. (FRAME or TIME)
 void Subtitle::set_duration_value(const long &value) {
-  push_command("duration", to_string(value));
+  push_command(FIELD_DURATION, value);
 
+  get_model()->update_duration_value(get_num() - 1, value);
   (*m_iter)[column.duration_value] = value;
   update_characters_per_sec();
 }
@@ -390,8 +597,9 @@ Glib::ustring Subtitle::convert_value_to_view_mode(const long &value) {
 }
 
 void Subtitle::set_style(const Glib::ustring &style) {
-  push_command("style", style);
+  push_command(FIELD_STYLE, style);
 
+  get_model()->update_style(get_num() - 1, style);
   (*m_iter)[column.style] = style;
 }
 
@@ -400,8 +608,9 @@ Glib::ustring Subtitle::get_style() const {
 }
 
 void Subtitle::set_name(const Glib::ustring &name) {
-  push_command("name", name);
+  push_command(FIELD_NAME, name);
 
+  get_model()->update_name(get_num() - 1, name);
   (*m_iter)[column.name] = name;
 }
 
@@ -410,7 +619,7 @@ Glib::ustring Subtitle::get_name() const {
 }
 
 void Subtitle::set_margin_l(const Glib::ustring &value) {
-  push_command("margin-l", value);
+  push_command(FIELD_MARGIN_L, value);
 
   (*m_iter)[column.marginL] = value;
 }
@@ -420,7 +629,7 @@ Glib::ustring Subtitle::get_margin_l() const {
 }
 
 void Subtitle::set_margin_r(const Glib::ustring &value) {
-  push_command("margin-r", value);
+  push_command(FIELD_MARGIN_R, value);
 
   (*m_iter)[column.marginR] = value;
 }
@@ -430,7 +639,7 @@ Glib::ustring Subtitle::get_margin_r() const {
 }
 
 void Subtitle::set_margin_v(const Glib::ustring &value) {
-  push_command("margin-v", value);
+  push_command(FIELD_MARGIN_V, value);
 
   (*m_iter)[column.marginV] = value;
 }
@@ -440,7 +649,7 @@ Glib::ustring Subtitle::get_margin_v() const {
 }
 
 void Subtitle::set_effect(const Glib::ustring &effect) {
-  push_command("effect", effect);
+  push_command(FIELD_EFFECT, effect);
 
   (*m_iter)[column.effect] = effect;
 }
@@ -450,28 +659,14 @@ Glib::ustring Subtitle::get_effect() const {
 }
 
 void Subtitle::set_text(const Glib::ustring &text) {
-  push_command("text", text);
+  push_command(FIELD_TEXT, text);
 
+  get_model()->update_text(get_num() - 1, text);
   (*m_iter)[column.text] = text;
 
   // characters per line
-  if (text.size() == 0) {
-    (*m_iter)[column.characters_per_line_text] = "0";
-  } else {
-    std::vector<int> num_characters = utility::get_characters_per_line(text);
-    std::string cpl;
-
-    unsigned int count = 0;
-    for (const auto &number : num_characters) {
-      if (count == 0) {
-        cpl += to_string(number);
-      } else {
-        cpl += "\n" + to_string(number);
-      }
-      ++count;
-    }
-    (*m_iter)[column.characters_per_line_text] = cpl;
-  }
+  (*m_iter)[column.characters_per_line_text] =
+      utility::get_characters_per_line_string(text);
 
   update_characters_per_sec();
 }
@@ -481,29 +676,13 @@ Glib::ustring Subtitle::get_text() const {
 }
 
 void Subtitle::set_translation(const Glib::ustring &text) {
-  push_command("translation", text);
+  push_command(FIELD_TRANSLATION, text);
 
   (*m_iter)[column.translation] = text;
 
   // characters per line
-  if (text.size() == 0) {
-    (*m_iter)[column.characters_per_line_translation] = "0";
-  } else {
-    std::vector<int> num_characters = utility::get_characters_per_line(text);
-    std::string cpl;
-
-    unsigned int count = 0;
-    for (const auto &number : num_characters) {
-      if (count == 0) {
-        cpl += to_string(number);
-      } else {
-        cpl += "\n" + to_string(number);
-      }
-      ++count;
-    }
-
-    (*m_iter)[column.characters_per_line_translation] = cpl;
-  }
+  (*m_iter)[column.characters_per_line_translation] =
+      utility::get_characters_per_line_string(text);
 }
 
 Glib::ustring Subtitle::get_translation() const {
@@ -521,8 +700,7 @@ Glib::ustring Subtitle::get_characters_per_line_translation() const {
 }
 
 void Subtitle::set_characters_per_second_text(double cps) {
-  push_command("characters-per-second-text",
-               Glib::ustring::format(std::fixed, std::setprecision(1), cps));
+  push_command(FIELD_CHARACTERS_PER_SECOND_TEXT, cps);
 
   (*m_iter)[column.characters_per_second_text] = cps;
 }
@@ -539,10 +717,16 @@ Glib::ustring Subtitle::get_characters_per_second_text_string() const {
 // Checks if the cps of this subtitle is within the specified bounds
 // result: 0 - okay, <0 - too low, >0 - too high
 int Subtitle::check_cps_text(double mincps, double maxcps) {
+  return check_cps(get_characters_per_second_text(), mincps, maxcps);
+}
+
+// Checks if the cps is within the specified bounds
+// result: 0 - okay, <0 - too low, >0 - too high
+int Subtitle::check_cps(double cps, double mincps, double maxcps) {
   int retval = 0;
 
   // round cps to 1/10 precision
-  double cps = round(10.0 * get_characters_per_second_text()) / 10.0;
+  cps = round(10.0 * cps) / 10.0;
 
   // FIXME tomas-kitone, before fixing this strange comparing code,
   // try uncommenting the printf below, compiling subtitleeditor, setting max
@@ -566,7 +750,7 @@ int Subtitle::check_cps_text(double mincps, double maxcps) {
 }
 
 void Subtitle::set_note(const Glib::ustring &text) {
-  push_command("note", text);
+  push_command(FIELD_NOTE, text);
 
   (*m_iter)[column.note] = text;
 }
@@ -575,6 +759,14 @@ Glib::ustring Subtitle::get_note() const {
   return (*m_iter)[column.note];
 }
 
+void Subtitle::set_errors(guint errors) {
+  get_model()->set_errors(get_num() - 1, errors);
+}
+
+guint Subtitle::get_errors() const {
+  return get_model()->get_errors(get_num() - 1);
+}
+
 // copie le s-t dans sub
 void Subtitle::copy_to(Subtitle &sub) {
   sub.set_layer(get_layer());
@@ -593,8 +785,9 @@ void Subtitle::copy_to(Subtitle &sub) {
 void Subtitle::set(const Glib::ustring &name, const Glib::ustring &value) {
   se_dbg_msg(SE_DBG_APP, "name=<%s> value=<%s>", name.c_str(), value.c_str());
 
+  // The path is the position of the row, it can't be set
   if (name == "path")
-    m_path = value;
+    return;
   else if (name == "start")
     set_start_value(utility::string_to_long(value));
   else if (name == "end")
@@ -629,7 +822,8 @@ void Subtitle::set(const Glib::ustring &name, const Glib::ustring &value) {
 
 Glib::ustring Subtitle::get(const Glib::ustring &name) const {
   if (name == "path")
-    return m_path;
+    return (m_iter) ? m_document->get_subtitle_model()->get_string(m_iter)
+                    : Glib::ustring();
   else if (name == "start")
     return to_string(get_start_value());
   else if (name == "end")
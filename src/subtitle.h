@@ -56,9 +56,6 @@ class Subtitle {
   bool operator==(const Subtitle &sub) const;
   bool operator!=(const Subtitle &sub) const;
 
-  // Set the number of subtitle.
-  void set_num(unsigned int num);
-
   // Return the number of subtitle.
   unsigned int get_num() const;
 
@@ -160,6 +157,14 @@ class Subtitle {
 
   Glib::ustring get_note() const;
 
+  // The errors found by the live error checking, one bit by checker.
+  // It's computed from the other values, so it's not recorded by the
+  // command system. It's kept beside the model, a change doesn't emit
+  // row-changed, only the document signal "subtitle-errors-changed".
+  void set_errors(guint errors);
+
+  guint get_errors() const;
+
   // copie le s-t dans sub
   void copy_to(Subtitle &sub);
 
@@ -201,8 +206,34 @@ class Subtitle {
   // result: 0 - okay, <0 - too low, >0 - too high
   int check_cps_text(double mincps, double maxcps);
 
+  // Checks if the cps is within the specified bounds
+  // result: 0 - okay, <0 - too low, >0 - too high
+  static int check_cps(double cps, double mincps, double maxcps);
+
  protected:
-  void push_command(const Glib::ustring &name, const Glib::ustring &value);
+  // The values recorded by the command system. The numbers first, then the
+  // real and the strings.
+  enum Field {
+    FIELD_START,
+    FIELD_END,
+    FIELD_DURATION,
+    FIELD_CHARACTERS_PER_SECOND_TEXT,
+    FIELD_LAYER,
+    FIELD_STYLE,
+    FIELD_NAME,
+    FIELD_MARGIN_L,
+    FIELD_MARGIN_R,
+    FIELD_MARGIN_V,
+    FIELD_EFFECT,
+    FIELD_TEXT,
+    FIELD_TRANSLATION,
+    FIELD_NOTE
+  };
+
+  // Record the change with the old value, when the document is recording.
+  void push_command(Field field, long value);
+  void push_command(Field field, double value);
+  void push_command(Field field, const Glib::ustring &value);
 
   void update_characters_per_sec();
 
@@ -236,9 +267,11 @@ class Subtitle {
   // Get the duration value in the subtitle time mode. (FRAME or TIME)
   long get_duration_value() const;
 
+  // The model of the document, the setters keep its store up to date.
+  Glib::RefPtr<SubtitleModel> get_model() const;
+
  protected:
   static SubtitleColumnRecorder column;
   Document *m_document{nullptr};
   Gtk::TreeIter m_iter;
-  Glib::ustring m_path;
 };
@@ -18,6 +18,8 @@
 // You should have received a copy of the GNU General Public License
 // along with this program. If not, see <http://www.gnu.org/licenses/>.
 
+#include <cctype>
+#include <cstring>
 #include <map>
 #include <memory>
 #include "error.h"
@@ -42,35 +44,197 @@ SubtitleFormatSystem::SubtitleFormatSystem() {
 SubtitleFormatSystem::~SubtitleFormatSystem() {
 }
 
+namespace {
+
+// Return the position of the last character of the escape sequence, 'i' is
+// the character after the backslash. The arguments of the escapes (\x41,
+// \x{263a}, \012, \10, \p{L}, \cA, \Q...\E, ...) are skipped.
+std::string::size_type skip_escape(const std::string &pattern,
+                                   std::string::size_type i) {
+  const std::string::size_type size = pattern.size();
+  const char c = pattern[i];
+
+  // The argument between braces (or angle brackets)
+  if (i + 1 < size && (pattern[i + 1] == '{' || pattern[i + 1] == '<') &&
+      strchr("xopPNgk", c) != nullptr) {
+    std::string::size_type end =
+        pattern.find(pattern[i + 1] == '{' ? '}' : '>', i + 1);
+    return (end == std::string::npos) ? size - 1 : end;
+  }
+
+  auto is_octal = [](char d) { return d >= '0' && d <= '7'; };
+  auto is_hex = [](char d) { return isxdigit(static_cast<unsigned char>(d)); };
+  auto is_digit = [](char d) { return isdigit(static_cast<unsigned char>(d)); };
+
+  if (c == 'x') {
+    for (int n = 0; n < 2 && i + 1 < size && is_hex(pattern[i + 1]); ++n)
+      ++i;
+  } else if (c == '0') {
+    for (int n = 0; n < 2 && i + 1 < size && is_octal(pattern[i + 1]); ++n)
+      ++i;
+  } else if (is_digit(c)) {
+    while (i + 1 < size && is_digit(pattern[i + 1]))
+      ++i;
+  } else if (c == 'p' || c == 'P' || c == 'c') {
+    // \pL or \cA
+    if (i + 1 < size)
+      ++i;
+  } else if (c == 'Q') {
+    std::string::size_type end = pattern.find("\\E", i + 1);
+    i = (end == std::string::npos) ? size - 1 : end + 1;
+  }
+  return i;
+}
+
+// Return the longest literal string which must be present in the text to be
+// matched by the pattern, or an empty string if there's none.
+// This is used to quickly discard a format without running the regex.
+// ex: "^ScriptType:\\s*[vV]4.00$" -> "ScriptType:"
+//     "\\d\\R\\d+:\\d+:\\d+,\\d+\\s-->\\s..." -> "-->"
+std::string get_required_literal(const std::string &pattern) {
+  std::string best, run;
+  int depth = 0;
+
+  auto end_run = [&]() {
+    if (run.size() > best.size())
+      best = run;
+    run.clear();
+  };
+
+  for (std::string::size_type i = 0; i < pattern.size(); ++i) {
+    char c = pattern[i];
+    if (c == '\\') {
+      if (i + 1 >= pattern.size())
+        break;
+      char n = pattern[++i];
+      // \d, \s, \R, \1, \x41... are not literals
+      if (isalnum(static_cast<unsigned char>(n)) || depth > 0) {
+        end_run();
+        i = skip_escape(pattern, i);
+      } else {
+        run += n;
+      }
+    } else if (c == '[') {
+      // skip the class
+      end_run();
+      for (++i; i < pattern.size() && pattern[i] != ']'; ++i) {
+        if (pattern[i] == '\\')
+          ++i;
+      }
+    } else if (c == '(') {
+      end_run();
+      ++depth;
+    } else if (c == ')') {
+      end_run();
+      --depth;
+    } else if (c == '|') {
+      // an alternative at the top level, nothing is required
+      if (depth == 0)
+        return std::string();
+      end_run();
+    } else if (c == '*' || c == '?' || c == '{') {
+      // the previous character may be optional
+      if (!run.empty())
+        run.erase(run.size() - 1);
+      end_run();
+      if (c == '{')
+        i = pattern.find('}', i);
+      if (i == std::string::npos)
+        break;
+    } else if (c == '+' || c == '.' || c == '^' || c == '$') {
+      end_run();
+    } else if (depth == 0) {
+      run += c;
+    } else {
+      end_run();
+    }
+  }
+  end_run();
+  return best;
+}
+
+}  // namespace
+
+// Return the matcher of the subtitle format. The regex is compiled only once
+// and kept until the pattern changes.
+const SubtitleFormatSystem::FormatMatcher &SubtitleFormatSystem::get_matcher(
+    const SubtitleFormatInfo &info) {
+  auto it = m_matchers.find(info.name);
+  if (it != m_matchers.end() && it->second.pattern == info.pattern)
+    return it->second;
+
+  se_dbg_msg(SE_DBG_APP, "Compile the pattern of the '%s' format",
+             info.name.c_str());
+
+  FormatMatcher &matcher = m_matchers[info.name];
+  matcher.pattern = info.pattern;
+  matcher.literal = get_required_literal(info.pattern.raw());
+  try {
+    matcher.regex = Glib::Regex::create(
+        info.pattern, Glib::REGEX_MULTILINE | Glib::REGEX_OPTIMIZE);
+  } catch (const Glib::Error &ex) {
+    se_dbg_msg(SE_DBG_APP, "Could not compile the pattern of '%s': %s",
+               info.name.c_str(), ex.what().c_str());
+    matcher.regex.reset();
+  }
+  return matcher;
+}
+
 // Try to determine the format of the subtitles in the submitted FileReader
 // Exceptions:
 // UnrecognizeFormatError.
 Glib::ustring SubtitleFormatSystem::get_subtitle_format_from_small_contents(
     Reader *reader) {
-  const Glib::ustring &contents = reader->get_data();
-
-  se_dbg_msg(SE_DBG_APP, "small content:\n%s", contents.c_str());
+  const Glib::ustring &data = reader->get_data();
 
-  Glib::RegexCompileFlags compile_flags = Glib::REGEX_MULTILINE;
+  se_dbg_msg(SE_DBG_APP, "small content:\n%s", data.c_str());
 
   se_dbg_msg(SE_DBG_APP, "Trying to determinate the file format...");
 
+  Glib::Timer timer;
+
+  // Ignore the BOM, the patterns using '^' can't match the first line with it
+  Glib::ustring without_bom;
+  if (data.raw().compare(0, 3, "\xEF\xBB\xBF") == 0)
+    without_bom = data.raw().substr(3);
+  const Glib::ustring &contents = without_bom.empty() ? data : without_bom;
+
+  unsigned int regex_tested = 0;
+
   auto list_of_sf = get_subtitle_format_list();
   for (const auto &sf : list_of_sf) {
     SubtitleFormatInfo sfi = sf->get_info();
 
-    se_dbg_msg(SE_DBG_APP, "Try with '%s' format", sfi.name.c_str());
+    const FormatMatcher &matcher = get_matcher(sfi);
+
+    // First stage, the required literal must be in the contents
+    if (!matcher.literal.empty() &&
+        contents.raw().find(matcher.literal) == std::string::npos)
+      continue;
 
-    Glib::ustring pattern = sfi.pattern;
+    if (!matcher.regex)
+      continue;
+
+    se_dbg_msg(SE_DBG_APP, "Try with '%s' format", sfi.name.c_str());
 
-    if (Glib::Regex::match_simple(pattern, contents, compile_flags)) {
+    ++regex_tested;
+    if (matcher.regex->match(contents)) {
       Glib::ustring name = sfi.name;
 
       se_dbg_msg(SE_DBG_APP, "Determine the format as '%s'", name.c_str());
+      se_dbg_msg(SE_DBG_PROFILING,
+                 "format detection: %f s (%u formats, %u regex tested)",
+                 timer.elapsed(), static_cast<unsigned int>(list_of_sf.size()),
+                 regex_tested);
       return name;
     }
   }
 
+  se_dbg_msg(SE_DBG_PROFILING,
+             "format detection failed: %f s (%u formats, %u regex tested)",
+             timer.elapsed(), static_cast<unsigned int>(list_of_sf.size()),
+             regex_tested);
+
   throw UnrecognizeFormatError(_("Couldn't recognize format of the file."));
 }
 
@@ -126,7 +290,17 @@ void SubtitleFormatSystem::open_from_reader(Document *document, Reader *reader,
   // init the reader
   std::unique_ptr<SubtitleFormatIO> sfio(create_subtitle_format_io(format));
   sfio->set_document(document);
-  sfio->open(*reader);
+
+  // The subtitles are numbered and indexed once, after the reading
+  Subtitles subtitles = document->subtitles();
+  subtitles.begin_bulk_edit();
+  try {
+    sfio->open(*reader);
+  } catch (...) {
+    subtitles.end_bulk_edit();
+    throw;
+  }
+  subtitles.end_bulk_edit();
 
   se_dbg_msg(SE_DBG_APP, "Sets the document property ...");
 
@@ -231,6 +405,23 @@ void SubtitleFormatSystem::save_to_uri(Document *document,
 // Exceptions: UnrecognizeFormatError, Glib::Error...
 void SubtitleFormatSystem::save_to_data(Document *document, Glib::ustring &dst,
                                         const Glib::ustring &format) {
+  write_to_data(document, dst, format);
+
+  se_dbg_msg(SE_DBG_APP, "Update the document property...");
+
+  document->setCharset("UTF-8");
+  document->setFilename("");
+  document->setFormat(format);
+  document->make_document_unchanged();
+  document->emit_signal("document-property-changed");
+
+  se_dbg_msg(SE_DBG_APP, "Succesfully saved to ustring.");
+}
+
+// Write the document to a ustring, the document is unchanged.
+void SubtitleFormatSystem::write_to_data(Document *document,
+                                         Glib::ustring &dst,
+                                         const Glib::ustring &format) {
   se_dbg_msg(SE_DBG_APP,
              "Trying to save to ustring as subtitles in the '%s' format.",
              format.c_str());
@@ -245,19 +436,7 @@ void SubtitleFormatSystem::save_to_data(Document *document, Glib::ustring &dst,
 
   sfio->save(writer);
 
-  se_dbg_msg(SE_DBG_APP, "Save to the file...");
-
   dst = writer.get_data();
-
-  se_dbg_msg(SE_DBG_APP, "Update the document property...");
-
-  document->setCharset("UTF-8");
-  document->setFilename("");
-  document->setFormat(format);
-  document->make_document_unchanged();
-  document->emit_signal("document-property-changed");
-
-  se_dbg_msg(SE_DBG_APP, "Succesfully saved to ustring.");
 }
 
 // Returns all information about supported subtitles.
@@ -20,6 +20,8 @@
 // You should have received a copy of the GNU General Public License
 // along with this program. If not, see <http://www.gnu.org/licenses/>.
 
+#include <map>
+#include <string>
 #include "document.h"
 #include "subtitleformatio.h"
 
@@ -59,6 +61,13 @@ class SubtitleFormatSystem {
   void save_to_data(Document *document, Glib::ustring &dst,
                     const Glib::ustring &format);
 
+  // Write the document to a ustring without changing the properties of the
+  // document (filename, format, changed state...). Charset is UTF-8, newline
+  // is Unix.
+  // Exceptions: UnrecognizeFormatError, Glib::Error...
+  void write_to_data(Document *document, Glib::ustring &dst,
+                     const Glib::ustring &format);
+
   // Returns all information about supported subtitles.
   std::list<SubtitleFormatInfo> get_infos();
 
@@ -107,4 +116,20 @@ class SubtitleFormatSystem {
   // Exceptions: UnrecognizeFormatError, Glib::Error...
   void open_from_reader(Document *document, Reader *reader,
                         const Glib::ustring &format = Glib::ustring());
+
+ protected:
+  // The compiled pattern of a subtitle format.
+  struct FormatMatcher {
+    // The source pattern (SubtitleFormatInfo.pattern)
+    Glib::ustring pattern;
+    // A literal string required by the pattern, used as a cheap first stage
+    std::string literal;
+    Glib::RefPtr<Glib::Regex> regex;
+  };
+
+  // Return the matcher of the subtitle format, compile it if needed.
+  const FormatMatcher &get_matcher(const SubtitleFormatInfo &info);
+
+  // The matchers by format name
+  std::map<Glib::ustring, FormatMatcher> m_matchers;
 };
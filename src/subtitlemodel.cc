@@ -19,6 +19,7 @@
 // along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 #include <gtkmm/treemodel.h>
+#include <algorithm>
 #include "command.h"
 #include "debug.h"
 #include "document.h"
@@ -44,14 +45,16 @@ class AddSubtitleCommand : public Command {
     get_document_subtitle_model()->move(
         iter, get_document_subtitle_model()->get_iter(path));
 
-    get_document_subtitle_model()->rebuild_column_num();
   }
 
   void restore() {
     Gtk::TreeIter iter =
         get_document_subtitle_model()->get_iter(m_backup["path"]);
     get_document_subtitle_model()->erase(iter);
-    get_document_subtitle_model()->rebuild_column_num();
+  }
+
+  std::size_t get_size() const {
+    return Command::get_size() + Command::get_size(m_backup);
   }
 
  protected:
@@ -70,7 +73,6 @@ class RemoveSubtitleCommand : public Command {
     Gtk::TreeIter iter =
         get_document_subtitle_model()->get_iter(m_backup["path"]);
     get_document_subtitle_model()->erase(iter);
-    get_document_subtitle_model()->rebuild_column_num();
   }
 
   void restore() {
@@ -84,7 +86,10 @@ class RemoveSubtitleCommand : public Command {
     get_document_subtitle_model()->move(
         iter, get_document_subtitle_model()->get_iter(path));
 
-    get_document_subtitle_model()->rebuild_column_num();
+  }
+
+  std::size_t get_size() const {
+    return Command::get_size() + Command::get_size(m_backup);
   }
 
  protected:
@@ -93,53 +98,40 @@ class RemoveSubtitleCommand : public Command {
 
 SubtitleModel::SubtitleModel(Document *doc) : m_document(doc) {
   set_column_types(m_column);
+
+  signal_row_inserted().connect(
+      sigc::mem_fun(*this, &SubtitleModel::on_index_row_inserted));
+  signal_row_deleted().connect(
+      sigc::mem_fun(*this, &SubtitleModel::on_index_row_deleted));
+  signal_rows_reordered().connect(
+      sigc::mem_fun(*this, &SubtitleModel::on_index_rows_reordered));
+  signal_row_changed().connect(
+      sigc::mem_fun(*this, &SubtitleModel::on_index_row_changed));
 }
 
 Gtk::TreeIter SubtitleModel::append() {
   Gtk::TreeIter it = Gtk::ListStore::append();
   init(it);
-
-  (*it)[m_column.num] = getSize();
   return it;
 }
 
 // insert sub avant iter et retourne l'iter de sub
-// et declale tout les autres (sub.num)
 Gtk::TreeIter SubtitleModel::insertBefore(Gtk::TreeIter &iter) {
   Gtk::TreeIter res = insert(iter);
   init(res);
-  (*res)[m_column.num] = (unsigned int)(*iter)[m_column.num];
-
-  for (; iter; ++iter) {
-    (*iter)[m_column.num] = (*iter)[m_column.num] + 1;
-  }
   return res;
 }
 
 // insert sub apres iter et retourne l'iter de sub
-// et declale tout les autres (sub.num)
 Gtk::TreeIter SubtitleModel::insertAfter(Gtk::TreeIter &iter) {
   Gtk::TreeIter res = insert_after(iter);
   init(res);
-
-  (*res)[m_column.num] = (*iter)[m_column.num] + 1;
-
-  ++iter;  // le nouveau ajouter
-  ++iter;  // le suivant on commence a partir de lui
-
-  for (; iter; ++iter) {
-    (*iter)[m_column.num] = (*iter)[m_column.num] + 1;
-  }
-
   return res;
 }
 
-// efface un subtitle, on init les suivants avec le bon num
+// efface un subtitle
 void SubtitleModel::remove(Gtk::TreeIter &it) {
-  Gtk::TreeIter iter = erase(it);
-  for (; iter; ++iter) {
-    (*iter)[m_column.num] = (*iter)[m_column.num] - 1;
-  }
+  erase(it);
 }
 
 void SubtitleModel::remove(unsigned int start, unsigned int end) {
@@ -156,14 +148,6 @@ void SubtitleModel::remove(unsigned int start, unsigned int end) {
     for (; a != b;) {
       a = erase(a);
     }
-
-    // on decale num des suivants si il y en a
-    if (b) {
-      int diff = end - start + 1;
-      for (; b; ++b) {
-        (*b)[m_column.num] = (*b)[m_column.num] - diff;
-      }
-    }
   } else {
     for (; a;) {
       a = erase(a);
@@ -173,13 +157,14 @@ void SubtitleModel::remove(unsigned int start, unsigned int end) {
 
 // init l'iter a 0
 void SubtitleModel::init(Gtk::TreeIter &iter) {
-  (*iter)[m_column.num] = 0;
-
   // The visual value. Depend of *_value
 
   Glib::ustring default_view_value =
       (m_document->get_edit_timing_mode() == TIME) ? SubtitleTime::null() : "0";
 
+  // A new row of the store is already empty, only the style differs
+  update_style(get_path(iter)[0], "Default");
+
   // The real value of time
   (*iter)[m_column.start_value] = 0;
   (*iter)[m_column.end_value] = 0;
@@ -236,62 +221,78 @@ unsigned int SubtitleModel::getSize() {
 
 // recherche un subtitle
 // grace a son numero
+// The number is the position of the row (num = row + 1).
 Gtk::TreeIter SubtitleModel::find(unsigned int num) {
-  Gtk::TreeNodeChildren rows = children();
-  for (Gtk::TreeIter it = rows.begin(); it; ++it) {
-    if ((*it)[m_column.num] == num)
-      return it;
-  }
+  if (num > 0 && num <= getSize())
+    return children()[num - 1];
+
   Gtk::TreeIter nul;
   return nul;
 }
 
-Gtk::TreeIter SubtitleModel::find(const SubtitleTime &time) {
-  // We need to convert time to frame if the current model is frame based.
-  long val = 0;
+unsigned int SubtitleModel::get_num(const Gtk::TreeIter &iter) {
+  if (!iter)
+    return 0;
+  return get_path(iter)[0] + 1;
+}
+
+// We need to convert time to frame if the current model is frame based.
+long SubtitleModel::time_to_model_value(const SubtitleTime &time) {
   if (m_document->get_timing_mode() == TIME)
-    val = time.totalmsecs;
-  else
-    val = SubtitleTime::time_to_frame(
-        time, get_framerate_value(m_document->get_framerate()));
+    return time.totalmsecs;
+  return SubtitleTime::time_to_frame(
+      time, get_framerate_value(m_document->get_framerate()));
+}
+
+// Use the time index, a binary search instead of walking the whole model.
+Gtk::TreeIter SubtitleModel::find(const SubtitleTime &time) {
+  int row = m_time_index.find_first(time_to_model_value(time));
+  if (row >= 0)
+    return children()[row];
 
-  Gtk::TreeNodeChildren rows = children();
-  for (Gtk::TreeIter it = rows.begin(); it; ++it) {
-    if (val >= long((*it)[m_column.start_value]) &&
-        val <= long((*it)[m_column.end_value]))
-      return it;
-  }
   Gtk::TreeIter nul;
   return nul;
 }
 
-// hack ?
-bool compare_str(const Glib::ustring &src, const Glib::ustring &txt) {
-  unsigned int size = src.size();
-  if (txt.size() < size) {
-    for (unsigned int i = 0; i <= size - txt.size(); ++i) {
-      if (src.substr(i, txt.size()) == txt) {
-        return true;
-      }
-    }
+std::vector<Gtk::TreeIter> SubtitleModel::find_all(const SubtitleTime &time) {
+  std::vector<unsigned int> rows =
+      m_time_index.find_all(time_to_model_value(time));
+
+  Gtk::TreeNodeChildren nodes = children();
+  std::vector<Gtk::TreeIter> iters(rows.size());
+  for (unsigned int i = 0; i < rows.size(); ++i) {
+    iters[i] = nodes[rows[i]];
   }
+  return iters;
+}
 
-  return false;
+std::vector<Gtk::TreeIter> SubtitleModel::find_range(const SubtitleTime &start,
+                                                     const SubtitleTime &end) {
+  std::vector<unsigned int> rows = m_time_index.find_range(
+      time_to_model_value(start), time_to_model_value(end));
+
+  Gtk::TreeNodeChildren nodes = children();
+  std::vector<Gtk::TreeIter> iters(rows.size());
+  for (unsigned int i = 0; i < rows.size(); ++i) {
+    iters[i] = nodes[rows[i]];
+  }
+  return iters;
 }
 
 // recherche a partir de start (+1) dans le text des subtitles
 Gtk::TreeIter SubtitleModel::find_text(Gtk::TreeIter &start,
                                        const Glib::ustring &text) {
   if (start) {
-    Glib::ustring it_text;
-    Gtk::TreeIter it = start;
-    ++it;
-
-    for (; it; ++it) {
-      it_text = (*it)[m_column.text];
-
-      if (compare_str(it_text, text))
-        return it;
+    Gtk::TreeNodeChildren rows = children();
+    unsigned int row = get_path(start)[0] + 1;
+    for (; row < m_store.size(); ++row) {
+      unsigned int length = 0;
+      const char *data = m_store.get_text_data(row, length);
+      // The text must be longer than the pattern
+      if (length > text.bytes() &&
+          std::search(data, data + length, text.raw().begin(),
+                      text.raw().end()) != data + length)
+        return rows[row];
     }
   }
   Gtk::TreeIter nul;
@@ -330,11 +331,11 @@ void SubtitleModel::copy(Glib::RefPtr<SubtitleModel> src) {
 
   Gtk::TreeNodeChildren rows = src->children();
 
+  freeze_index();
+
   for (Gtk::TreeIter it = rows.begin(); it; ++it) {
     Gtk::TreeIter new_it = Gtk::ListStore::append();
 
-    SET(num, unsigned int);
-
     SET(layer, Glib::ustring);
 
     SET(start_value, long);
@@ -360,16 +361,63 @@ void SubtitleModel::copy(Glib::RefPtr<SubtitleModel> src) {
     SET(note, Glib::ustring);
   }
 #undef SET
+
+  thaw_index();
 }
 
-// check la colonne num pour init de [1,size]
-void SubtitleModel::rebuild_column_num() {
-  unsigned int id = 1;
-  Gtk::TreeNodeChildren rows = children();
+Gtk::TreeIter SubtitleModel::insert_rows(unsigned int position,
+                                         unsigned int n) {
+  g_return_val_if_fail(n > 0, Gtk::TreeIter());
+
+  unsigned int size = getSize();
+  if (position > size)
+    position = size;
 
-  for (Gtk::TreeIter it = rows.begin(); it; ++it, ++id) {
-    (*it)[m_column.num] = id;
+  freeze_index();
+
+  Gtk::TreeIter next;
+  if (position < size)
+    next = children()[position];
+
+  Gtk::TreeIter first;
+  for (unsigned int i = 0; i < n; ++i) {
+    Gtk::TreeIter it = next ? insert(next) : Gtk::ListStore::append();
+    init(it);
+    if (!first)
+      first = it;
   }
+
+  thaw_index();
+  return first;
+}
+
+void SubtitleModel::erase_rows(unsigned int position, unsigned int n) {
+  unsigned int size = getSize();
+  g_return_if_fail(position < size && n > 0);
+
+  freeze_index();
+
+  Gtk::TreeIter it = children()[position];
+  for (unsigned int i = 0; i < n && it; ++i) {
+    it = erase(it);
+  }
+
+  thaw_index();
+}
+
+void SubtitleModel::begin_bulk_edit() {
+  if (m_bulk_edit++ == 0)
+    m_document->emit_signal("subtitle-bulk-edit-begin");
+  freeze_index();
+}
+
+void SubtitleModel::end_bulk_edit() {
+  g_return_if_fail(m_bulk_edit > 0);
+
+  thaw_index();
+
+  if (--m_bulk_edit == 0)
+    m_document->emit_signal("subtitle-bulk-edit-end");
 }
 
 bool SubtitleModel::drag_data_delete_vfunc(const TreeModel::Path &path) {
@@ -377,11 +425,7 @@ bool SubtitleModel::drag_data_delete_vfunc(const TreeModel::Path &path) {
       new RemoveSubtitleCommand(m_document, get_iter(path)));
   m_document->finish_command();
 
-  bool res = Gtk::ListStore::drag_data_delete_vfunc(path);
-
-  rebuild_column_num();
-
-  return res;
+  return Gtk::ListStore::drag_data_delete_vfunc(path);
 }
 
 bool SubtitleModel::drag_data_received_vfunc(
@@ -391,8 +435,187 @@ bool SubtitleModel::drag_data_received_vfunc(
 
   Gtk::ListStore::drag_data_received_vfunc(dest, selection_data);
 
+  // The values are copied by the ListStore, not by the Subtitle setters
+  unsigned int row = dest[0];
+  if (can_update_row(row)) {
+    update_store(row, get_iter(dest));
+    m_time_index.update(row, m_store.get_start(row), m_store.get_end(row));
+  }
+
   m_document->start_command(_("Reordered Subtitle"));
   m_document->add_command(new AddSubtitleCommand(m_document, get_iter(dest)));
 
   return true;
 }
+
+const SubtitleStore &SubtitleModel::get_store() const {
+  return m_store;
+}
+
+bool SubtitleModel::can_update_row(unsigned int row) {
+  if (m_index_frozen > 0) {
+    m_index_dirty = true;
+    return false;
+  }
+  return row < m_store.size();
+}
+
+void SubtitleModel::update_start_value(unsigned int row, long value) {
+  if (!can_update_row(row))
+    return;
+  long end = m_store.get_end(row);
+  m_time_index.update(row, value, end);
+  m_store.set_times(row, value, end, m_store.get_duration(row));
+}
+
+void SubtitleModel::update_end_value(unsigned int row, long value) {
+  if (!can_update_row(row))
+    return;
+  long start = m_store.get_start(row);
+  m_time_index.update(row, start, value);
+  m_store.set_times(row, start, value, m_store.get_duration(row));
+}
+
+void SubtitleModel::update_duration_value(unsigned int row, long value) {
+  if (!can_update_row(row))
+    return;
+  m_store.set_times(row, m_store.get_start(row), m_store.get_end(row), value);
+}
+
+void SubtitleModel::update_style(unsigned int row,
+                                 const Glib::ustring &style) {
+  if (can_update_row(row))
+    m_store.set_style(row, style.raw());
+}
+
+void SubtitleModel::update_name(unsigned int row, const Glib::ustring &name) {
+  if (can_update_row(row))
+    m_store.set_name(row, name.raw());
+}
+
+void SubtitleModel::update_text(unsigned int row, const Glib::ustring &text) {
+  if (can_update_row(row))
+    m_store.set_text(row, text.raw());
+}
+
+void SubtitleModel::set_errors(unsigned int row, guint errors) {
+  g_return_if_fail(row < m_errors.size());
+  m_errors[row] = errors;
+}
+
+guint SubtitleModel::get_errors(unsigned int row) const {
+  return (row < m_errors.size()) ? m_errors[row] : 0;
+}
+
+sigc::signal<void, unsigned int> &SubtitleModel::signal_subtitle_inserted() {
+  return m_signal_subtitle_inserted;
+}
+
+sigc::signal<void, unsigned int> &SubtitleModel::signal_subtitle_deleted() {
+  return m_signal_subtitle_deleted;
+}
+
+sigc::signal<void> &SubtitleModel::signal_subtitles_reordered() {
+  return m_signal_subtitles_reordered;
+}
+
+sigc::signal<void, unsigned int> &SubtitleModel::signal_subtitle_changed() {
+  return m_signal_subtitle_changed;
+}
+
+// The errors follow the rows even when the index is frozen.
+void SubtitleModel::on_index_row_inserted(const Gtk::TreePath &path,
+                                          const Gtk::TreeIter &) {
+  unsigned int row = path[0];
+  if (row > m_errors.size())
+    row = m_errors.size();
+  m_errors.insert(m_errors.begin() + row, 0);
+
+  if (m_index_frozen > 0) {
+    m_index_dirty = true;
+  } else {
+    m_time_index.insert(row);
+    m_store.insert(row);
+  }
+  m_signal_subtitle_inserted(row);
+}
+
+void SubtitleModel::on_index_row_deleted(const Gtk::TreePath &path) {
+  unsigned int row = path[0];
+  if (row < m_errors.size())
+    m_errors.erase(m_errors.begin() + row);
+
+  if (m_index_frozen > 0) {
+    m_index_dirty = true;
+  } else {
+    m_time_index.erase(row);
+    m_store.erase(row);
+  }
+  m_signal_subtitle_deleted(row);
+}
+
+void SubtitleModel::on_index_rows_reordered(const Gtk::TreePath &,
+                                            const Gtk::TreeIter &,
+                                            int *new_order) {
+  unsigned int size = getSize();
+  if (new_order != nullptr && size == m_errors.size()) {
+    std::vector<guint> errors(size);
+    for (unsigned int i = 0; i < size; ++i) {
+      errors[i] = m_errors[new_order[i]];
+    }
+    m_errors.swap(errors);
+  }
+
+  if (m_index_frozen > 0) {
+    m_index_dirty = true;
+  } else {
+    m_time_index.reorder(new_order, size);
+    m_store.reorder(new_order, size);
+  }
+  m_signal_subtitles_reordered();
+}
+
+// Called for every column change. The time index and the store are already
+// updated by the Subtitle setters (update_*), the row isn't read back.
+void SubtitleModel::on_index_row_changed(const Gtk::TreePath &path,
+                                         const Gtk::TreeIter &) {
+  m_signal_subtitle_changed(path[0]);
+}
+
+void SubtitleModel::update_store(unsigned int row, const Gtk::TreeIter &iter) {
+  m_store.set_times(row, (*iter)[m_column.start_value],
+                    (*iter)[m_column.end_value],
+                    (*iter)[m_column.duration_value]);
+  m_store.set_style(row, Glib::ustring((*iter)[m_column.style]).raw());
+  m_store.set_name(row, Glib::ustring((*iter)[m_column.name]).raw());
+  m_store.set_text(row, Glib::ustring((*iter)[m_column.text]).raw());
+}
+
+void SubtitleModel::freeze_index() {
+  ++m_index_frozen;
+}
+
+void SubtitleModel::thaw_index() {
+  g_return_if_fail(m_index_frozen > 0);
+
+  if (--m_index_frozen == 0 && m_index_dirty)
+    rebuild_index();
+}
+
+// One walk of the model instead of an update by row and by column.
+void SubtitleModel::rebuild_index() {
+  se_dbg(SE_DBG_APP);
+
+  m_store.clear();
+
+  unsigned int row = 0;
+  Gtk::TreeNodeChildren rows = children();
+  for (Gtk::TreeIter it = rows.begin(); it; ++it, ++row) {
+    m_store.insert(row);
+    update_store(row, it);
+  }
+
+  m_time_index.assign(m_store.get_start_values(), m_store.get_end_values(),
+                      m_store.size());
+  m_index_dirty = false;
+}
@@ -21,7 +21,9 @@
 // along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 #include <gtkmm.h>
+#include "subtitlestore.h"
 #include "subtitletime.h"
+#include "subtitletimeindex.h"
 
 class NameModel : public Gtk::ListStore {
  public:
@@ -47,7 +49,6 @@ class NameModel : public Gtk::ListStore {
 class SubtitleColumnRecorder : public Gtk::TreeModel::ColumnRecord {
  public:
   SubtitleColumnRecorder() {
-    add(num);
     add(layer);
     add(start_value);
     add(end_value);
@@ -68,8 +69,6 @@ class SubtitleColumnRecorder : public Gtk::TreeModel::ColumnRecord {
     add(note);
   }
 
-  Gtk::TreeModelColumn<unsigned int> num;
-
   Gtk::TreeModelColumn<Glib::ustring> layer;
 
   Gtk::TreeModelColumn<long> start_value;
@@ -104,7 +103,7 @@ class SubtitleModel : public Gtk::ListStore {
  public:
   SubtitleModel(Document *doc);
 
-  // num = 0, start=end=0, ...
+  // start=end=0, ...
   void init(Gtk::TreeIter &iter);
 
   Gtk::TreeIter append();
@@ -126,10 +125,24 @@ class SubtitleModel : public Gtk::ListStore {
   // grace a son numero
   Gtk::TreeIter find(unsigned int num);
 
+  // Return the number of the subtitle. The number isn't stored, it's the
+  // position of the row (num = row + 1), so a structural change doesn't
+  // touch the following rows.
+  unsigned int get_num(const Gtk::TreeIter &iter);
+
   // recherche un subtitle grace a son temps
   // si time est compris entre start et end
   Gtk::TreeIter find(const SubtitleTime &time);
 
+  // Return all the subtitles where start <= time <= end,
+  // sorted by the document order.
+  std::vector<Gtk::TreeIter> find_all(const SubtitleTime &time);
+
+  // Return all the subtitles intersecting [start, end],
+  // sorted by the document order.
+  std::vector<Gtk::TreeIter> find_range(const SubtitleTime &start,
+                                        const SubtitleTime &end);
+
   // recherche a partir de start (+1) dans le text des subtitles
   Gtk::TreeIter find_text(Gtk::TreeIter &start, const Glib::ustring &text);
 
@@ -143,14 +156,12 @@ class SubtitleModel : public Gtk::ListStore {
   // FONCTION D'EDITION
 
   // insert sub avant iter et retourne l'iter de sub
-  // puis declale tout les autres (num)
   Gtk::TreeIter insertBefore(Gtk::TreeIter &iter);
 
   // insert sub apres iter et retourne l'iter de sub
-  // et declale tout les autres (num)
   Gtk::TreeIter insertAfter(Gtk::TreeIter &iter);
 
-  // efface un subtitle, on init les suivants avec le bon num
+  // efface un subtitle
   void remove(Gtk::TreeIter &iter);
 
   // efface des elements de start a end
@@ -160,8 +171,43 @@ class SubtitleModel : public Gtk::ListStore {
   // fait une copy de src dans this
   void copy(Glib::RefPtr<SubtitleModel> src);
 
-  // check la colonne num pour init de [1,size]
-  void rebuild_column_num();
+  // Insert n new rows at the position (append if the position is after the
+  // last row) and return the first one. The rows are indexed once for all
+  // of them.
+  Gtk::TreeIter insert_rows(unsigned int position, unsigned int n);
+
+  // Remove n rows from the position.
+  void erase_rows(unsigned int position, unsigned int n);
+
+  // See Subtitles::begin_bulk_edit. The calls can be nested.
+  void begin_bulk_edit();
+  void end_bulk_edit();
+
+  // Return the columnar copy of the model, for the functions reading the
+  // values of many subtitles.
+  const SubtitleStore &get_store() const;
+
+  // Called by the Subtitle setters before the value is written in the row,
+  // only this value is copied in the time index and the store.
+  void update_start_value(unsigned int row, long value);
+  void update_end_value(unsigned int row, long value);
+  void update_duration_value(unsigned int row, long value);
+  void update_style(unsigned int row, const Glib::ustring &style);
+  void update_name(unsigned int row, const Glib::ustring &name);
+  void update_text(unsigned int row, const Glib::ustring &text);
+
+  // The bitmap of the errors found by the live error checking. It's not a
+  // column, setting it doesn't change the row.
+  void set_errors(unsigned int row, guint errors);
+  guint get_errors(unsigned int row) const;
+
+  // The rows (num - 1) inserted, deleted, reordered or changed, emitted once
+  // the time index is up to date. Allow to follow the subtitles without
+  // access to the model.
+  sigc::signal<void, unsigned int> &signal_subtitle_inserted();
+  sigc::signal<void, unsigned int> &signal_subtitle_deleted();
+  sigc::signal<void> &signal_subtitles_reordered();
+  sigc::signal<void, unsigned int> &signal_subtitle_changed();
 
  protected:
   virtual bool drag_data_delete_vfunc(const TreeModel::Path &path);
@@ -169,9 +215,50 @@ class SubtitleModel : public Gtk::ListStore {
   virtual bool drag_data_received_vfunc(
       const TreeModel::Path &dest, const Gtk::SelectionData &selection_data);
 
+  // Convert the time to the model timing mode (msecs or frame).
+  long time_to_model_value(const SubtitleTime &time);
+
+  // Keep the time index and the store synchronized with the model.
+  void on_index_row_inserted(const Gtk::TreePath &path,
+                             const Gtk::TreeIter &iter);
+  void on_index_row_deleted(const Gtk::TreePath &path);
+  void on_index_rows_reordered(const Gtk::TreePath &path,
+                               const Gtk::TreeIter &iter, int *new_order);
+  void on_index_row_changed(const Gtk::TreePath &path,
+                            const Gtk::TreeIter &iter);
+
+  // Copy the values of the row in the store.
+  void update_store(unsigned int row, const Gtk::TreeIter &iter);
+
+  // Return false if the row can't be updated now (the index is frozen), it's
+  // rebuilt when the index is thawed.
+  bool can_update_row(unsigned int row);
+
+  // While the index is frozen the row signals are ignored, the time index
+  // and the store are rebuilt from the model when it's thawed.
+  void freeze_index();
+  void thaw_index();
+  void rebuild_index();
+
  protected:
   Document *m_document;
   SubtitleColumnRecorder m_column;
+  SubtitleTimeIndex m_time_index;
+  SubtitleStore m_store;
+
+  // The errors by row, kept beside the model
+  std::vector<guint> m_errors;
+
+  sigc::signal<void, unsigned int> m_signal_subtitle_inserted;
+  sigc::signal<void, unsigned int> m_signal_subtitle_deleted;
+  sigc::signal<void> m_signal_subtitles_reordered;
+  sigc::signal<void, unsigned int> m_signal_subtitle_changed;
+
+  unsigned int m_index_frozen{0};
+  bool m_index_dirty{false};
+
+  // Depth of the bulk edit
+  unsigned int m_bulk_edit{0};
 
   sigc::signal<void, const Gtk::TreePath &, const Gtk::TreePath &>
       m_my_signal_row_reorderer;
@@ -18,6 +18,7 @@
 // You should have received a copy of the GNU General Public License
 // along with this program. If not, see <http://www.gnu.org/licenses/>.
 
+#include <algorithm>
 #include "document.h"
 #include "subtitles.h"
 #include "utility.h"
@@ -42,7 +43,6 @@ class AppendSubtitleCommand : public Command {
   void restore() {
     Gtk::TreeIter iter = get_document_subtitle_model()->get_iter(m_path);
     get_document_subtitle_model()->erase(iter);
-    get_document_subtitle_model()->rebuild_column_num();
   }
 
  protected:
@@ -58,9 +58,13 @@ class RemoveSubtitlesCommand : public Command {
     for (unsigned int i = 0; i < subtitles.size(); ++i) {
       subtitles[i].get(m_backup[i]);
     }
+    update_size();
   }
 
   void execute() {
+    if (!uncompress())
+      return;
+
     std::vector<std::map<Glib::ustring, Glib::ustring> >::reverse_iterator it;
 
     for (it = m_backup.rbegin(); it != m_backup.rend(); ++it) {
@@ -72,11 +76,13 @@ class RemoveSubtitlesCommand : public Command {
       // FIXME: updated gap after/before
     }
 
-    get_document_subtitle_model()->rebuild_column_num();
     document()->emit_signal("subtitle-deleted");
   }
 
   void restore() {
+    if (!uncompress())
+      return;
+
     std::vector<std::map<Glib::ustring, Glib::ustring> >::iterator it;
 
     for (it = m_backup.begin(); it != m_backup.end(); ++it) {
@@ -92,12 +98,91 @@ class RemoveSubtitlesCommand : public Command {
       // FIXME: updated gap after/before
     }
 
-    get_document_subtitle_model()->rebuild_column_num();
     document()->emit_signal("subtitle-insered");
   }
 
+  std::size_t get_size() const {
+    return m_size;
+  }
+
+  // The backup is serialized (key\0value\0 by value) and compressed.
+  void compress() {
+    if (m_backup.empty())
+      return;
+
+    std::string data;
+    for (const auto &values : m_backup) {
+      data += to_string(values.size());
+      data.push_back('\0');
+      for (const auto &v : values) {
+        data += v.first.raw();
+        data.push_back('\0');
+        data += v.second.raw();
+        data.push_back('\0');
+      }
+    }
+
+    if (!utility::compress(data, m_compressed)) {
+      m_compressed.clear();
+      return;
+    }
+    m_count = m_backup.size();
+    std::vector<std::map<Glib::ustring, Glib::ustring> >().swap(m_backup);
+    update_size();
+  }
+
+ protected:
+  // Return false if the backup can't be uncompressed, the command is then
+  // unusable and the compressed data is kept.
+  bool uncompress() {
+    if (m_compressed.empty())
+      return true;
+
+    std::string data;
+    if (!utility::uncompress(m_compressed, data)) {
+      g_warning("Could not uncompress the command '%s'",
+                description().c_str());
+      return false;
+    }
+    std::string().swap(m_compressed);
+
+    // Read the next string ending by \0
+    std::string::size_type pos = 0;
+    auto next = [&data, &pos]() {
+      std::string::size_type end = data.find('\0', pos);
+      if (end == std::string::npos)
+        end = data.size();
+      std::string str = data.substr(pos, end - pos);
+      pos = std::min(end + 1, data.size());
+      return str;
+    };
+
+    m_backup.resize(m_count);
+    for (auto &values : m_backup) {
+      int n = utility::string_to_int(next());
+      for (int i = 0; i < n; ++i) {
+        std::string key = next();
+        values[key] = next();
+      }
+    }
+    update_size();
+    return true;
+  }
+
+  void update_size() {
+    m_size = Command::get_size() + sizeof(*this) - sizeof(Command) +
+             m_compressed.capacity();
+    for (const auto &values : m_backup) {
+      m_size += Command::get_size(values);
+    }
+  }
+
  protected:
   std::vector<std::map<Glib::ustring, Glib::ustring> > m_backup;
+  // The backup when the command is compressed
+  std::string m_compressed;
+  std::size_t m_count{0};
+  std::size_t m_size{0};
 };
 
 class InsertSubtitleCommand : public Command {
@@ -119,14 +204,12 @@ class InsertSubtitleCommand : public Command {
     Gtk::TreeIter path = get_document_subtitle_model()->get_iter(m_path);
 
     get_document_subtitle_model()->move(newiter, path);
-    get_document_subtitle_model()->rebuild_column_num();
   }
 
   void restore() {
     Gtk::TreeIter iter = get_document_subtitle_model()->get_iter(m_path);
 
     get_document_subtitle_model()->erase(iter);
-    get_document_subtitle_model()->rebuild_column_num();
   }
 
  protected:
@@ -134,6 +217,25 @@ class InsertSubtitleCommand : public Command {
   Glib::ustring m_path;
 };
 
+class InsertSubtitlesCommand : public Command {
+ public:
+  InsertSubtitlesCommand(Document *doc, unsigned int position, unsigned int n)
+      : Command(doc, _("Insert Subtitles")), m_position(position), m_n(n) {
+  }
+
+  void execute() {
+    get_document_subtitle_model()->insert_rows(m_position, m_n);
+  }
+
+  void restore() {
+    get_document_subtitle_model()->erase_rows(m_position, m_n);
+  }
+
+ protected:
+  unsigned int m_position;
+  unsigned int m_n;
+};
+
 class ReorderSubtitlesCommand : public Command {
  public:
   ReorderSubtitlesCommand(Document *doc, std::vector<gint> &old_order,
@@ -145,12 +247,15 @@ class ReorderSubtitlesCommand : public Command {
 
   void execute() {
     get_document_subtitle_model()->reorder(m_new_order);
-    get_document_subtitle_model()->rebuild_column_num();
   }
 
   void restore() {
     get_document_subtitle_model()->reorder(m_old_order);
-    get_document_subtitle_model()->rebuild_column_num();
+  }
+
+  std::size_t get_size() const {
+    return Command::get_size() +
+           (m_new_order.capacity() + m_old_order.capacity()) * sizeof(gint);
   }
 
  protected:
@@ -162,21 +267,18 @@ class ReorderSubtitlesCommand : public Command {
 // information for sorted function.
 class SortedBuffer {
  public:
-  static bool compare_num_func(const SortedBuffer &a, const SortedBuffer &b) {
-    return (a.num < b.num);
-  }
-
   static bool compare_time_func(const SortedBuffer &a, const SortedBuffer &b) {
     return (a.time < b.time);
   }
 
-  static void create_buffers(Subtitles &subtitles,
-                             std::vector<SortedBuffer> &buf) {
-    gint index = 0;
-    for (Subtitle s = subtitles.get_first(); s; ++s, ++index) {
+  // Only the index and the time, read from the store.
+  static void create_time_buffers(Subtitles &subtitles,
+                                  std::vector<SortedBuffer> &buf) {
+    const SubtitleStore &store = subtitles.get_store();
+    const long *start = store.get_start_values();
+    for (guint index = 0; index < buf.size(); ++index) {
       buf[index].index = index;
-      buf[index].num = s.get_num();
-      buf[index].time = s.get_start().totalmsecs;
+      buf[index].time = start[index];
     }
   }
 
@@ -198,7 +300,6 @@ class SortedBuffer {
 
  public:
   gint index;
-  gint num;
   long time;
 };
 
@@ -264,6 +365,48 @@ Subtitle Subtitles::insert_after(const Subtitle &sub) {
                   m_document.get_subtitle_model()->insertAfter(iter));
 }
 
+Subtitle Subtitles::append(unsigned int n) {
+  return insert_rows(size(), n);
+}
+
+Subtitle Subtitles::insert_before(const Subtitle &sub, unsigned int n) {
+  g_return_val_if_fail(sub, Subtitle());
+
+  return insert_rows(m_document.get_subtitle_model()->get_path(sub.m_iter)[0],
+                     n);
+}
+
+Subtitle Subtitles::insert_after(const Subtitle &sub, unsigned int n) {
+  g_return_val_if_fail(sub, Subtitle());
+
+  return insert_rows(
+      m_document.get_subtitle_model()->get_path(sub.m_iter)[0] + 1, n);
+}
+
+Subtitle Subtitles::insert_rows(unsigned int position, unsigned int n) {
+  if (n == 0)
+    return Subtitle();
+
+  unsigned int count = size();
+  if (position > count)
+    position = count;
+
+  if (m_document.is_recording())
+    m_document.add_command(
+        new InsertSubtitlesCommand(&m_document, position, n));
+
+  return Subtitle(&m_document,
+                  m_document.get_subtitle_model()->insert_rows(position, n));
+}
+
+void Subtitles::begin_bulk_edit() {
+  m_document.get_subtitle_model()->begin_bulk_edit();
+}
+
+void Subtitles::end_bulk_edit() {
+  m_document.get_subtitle_model()->end_bulk_edit();
+}
+
 void Subtitles::remove(std::vector<Subtitle> &subs) {
   if (m_document.is_recording())
     m_document.add_command(new RemoveSubtitlesCommand(&m_document, subs));
@@ -280,7 +423,6 @@ void Subtitles::remove(std::vector<Subtitle> &subs) {
     if (next_sub)
       next_sub.update_gap_before();
   }
-  m_document.get_subtitle_model()->rebuild_column_num();
   m_document.emit_signal("subtitle-deleted");
 }
 
@@ -311,18 +453,56 @@ void Subtitles::remove(const Subtitle &sub) {
 }
 
 Subtitle Subtitles::find(const SubtitleTime &time) {
-  // Calling 'SubtitleModel::find' is doing the same thing
-  // that the next code, but in an optimized way
-  // Subtitle sub = get_first();
-  // while (sub) {
-  //   if (time >= sub.get_start() && time <= sub.get_end())
-  //     return sub;
-  //   ++sub;
-  // }
-  // return Subtitle();
+  // 'SubtitleModel::find' use an interval index (SubtitleTimeIndex) updated
+  // with the model, the lookup is O(log n) instead of walking every rows.
   return Subtitle(&m_document, m_document.get_subtitle_model()->find(time));
 }
 
+std::vector<Subtitle> Subtitles::find_all(const SubtitleTime &time) {
+  std::vector<Gtk::TreeIter> iters =
+      m_document.get_subtitle_model()->find_all(time);
+
+  std::vector<Subtitle> subs;
+  subs.reserve(iters.size());
+  for (const auto &iter : iters) {
+    subs.push_back(Subtitle(&m_document, iter));
+  }
+  return subs;
+}
+
+std::vector<Subtitle> Subtitles::find_range(const SubtitleTime &start,
+                                            const SubtitleTime &end) {
+  std::vector<Gtk::TreeIter> iters =
+      m_document.get_subtitle_model()->find_range(start, end);
+
+  std::vector<Subtitle> subs;
+  subs.reserve(iters.size());
+  for (const auto &iter : iters) {
+    subs.push_back(Subtitle(&m_document, iter));
+  }
+  return subs;
+}
+
+const SubtitleStore &Subtitles::get_store() {
+  return m_document.get_subtitle_model()->get_store();
+}
+
+sigc::signal<void, unsigned int> &Subtitles::signal_inserted() {
+  return m_document.get_subtitle_model()->signal_subtitle_inserted();
+}
+
+sigc::signal<void, unsigned int> &Subtitles::signal_deleted() {
+  return m_document.get_subtitle_model()->signal_subtitle_deleted();
+}
+
+sigc::signal<void> &Subtitles::signal_reordered() {
+  return m_document.get_subtitle_model()->signal_subtitles_reordered();
+}
+
+sigc::signal<void, unsigned int> &Subtitles::signal_changed() {
+  return m_document.get_subtitle_model()->signal_subtitle_changed();
+}
+
 // Selection
 
 std::vector<Subtitle> Subtitles::get_selection() {
@@ -416,7 +596,7 @@ guint Subtitles::sort_by_time() {
   std::vector<SortedBuffer> buf(number_of_subtitles);
 
   // Create the Buffer structure used to sort
-  SortedBuffer::create_buffers(*this, buf);
+  SortedBuffer::create_time_buffers(*this, buf);
   // Sort using the Time
   std::sort(buf.begin(), buf.end(), SortedBuffer::compare_time_func);
   SortedBuffer::to_vector(buf, new_order);
@@ -428,15 +608,9 @@ guint Subtitles::sort_by_time() {
   // Reorder the model
   m_document.get_subtitle_model()->reorder(new_order);
 
-  // We need to resort by using the subtitle number for Undo
-  // Create the Buffer structure used to sort
-  SortedBuffer::create_buffers(*this, buf);
-  // Sort using the Num this time
-  std::sort(buf.begin(), buf.end(), SortedBuffer::compare_num_func);
-  SortedBuffer::to_vector(buf, old_order);
-
-  // We can now update the num of subtitles
-  m_document.get_subtitle_model()->rebuild_column_num();
+  // The order for Undo is the inverse of the new order
+  for (guint index = 0; index < number_of_subtitles; ++index)
+    old_order[new_order[index]] = index;
 
   if (m_document.is_recording())
     m_document.add_command(
@@ -48,6 +48,24 @@ class Subtitles {
 
   Subtitle insert_after(const Subtitle &sub);
 
+  // Add n new subtitles and return the first one, the others follow it.
+  // The subtitles are indexed once for all of them, prefer these functions to
+  // add several subtitles.
+  Subtitle append(unsigned int n);
+
+  Subtitle insert_before(const Subtitle &sub, unsigned int n);
+
+  Subtitle insert_after(const Subtitle &sub, unsigned int n);
+
+  // Start a bulk edit, for the changes of many subtitles (reading a file,
+  // paste, join...). Until the matching end_bulk_edit the view is detached
+  // from the model, and the time index and the store are not updated (find
+  // and get_store are not reliable). They are rebuilt once at the end. The
+  // calls can be nested.
+  void begin_bulk_edit();
+
+  void end_bulk_edit();
+
   void remove(std::vector<Subtitle> &subs);
 
   void remove(unsigned int start, unsigned int end);
@@ -56,8 +74,29 @@ class Subtitles {
   // subtitles.
   void remove(const Subtitle &sub);
 
+  // Return the first subtitle (document order) where start <= time <= end.
   Subtitle find(const SubtitleTime &time);
 
+  // Return all the subtitles where start <= time <= end.
+  std::vector<Subtitle> find_all(const SubtitleTime &time);
+
+  // Return all the subtitles intersecting [start, end] (document order),
+  // only the subtitles in the range are visited.
+  std::vector<Subtitle> find_range(const SubtitleTime &start,
+                                   const SubtitleTime &end);
+
+  // Return the columnar copy of the subtitles (row = num - 1), faster than
+  // walking the subtitles to read the times, the style, the actor or the
+  // text of the whole document.
+  const SubtitleStore &get_store();
+
+  // Signals to follow the changes of the subtitles, the argument is the row
+  // (num - 1). "changed" is emitted for each value changed.
+  sigc::signal<void, unsigned int> &signal_inserted();
+  sigc::signal<void, unsigned int> &signal_deleted();
+  sigc::signal<void> &signal_reordered();
+  sigc::signal<void, unsigned int> &signal_changed();
+
   // Selection
 
   std::vector<Subtitle> get_selection();
@@ -83,6 +122,10 @@ class Subtitles {
 
   guint sort_by_time();
 
+ protected:
+  // Insert n subtitles at the row position (recorded).
+  Subtitle insert_rows(unsigned int position, unsigned int n);
+
  protected:
   Document &m_document;
 };
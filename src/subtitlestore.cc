@@ -0,0 +1,224 @@
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://kitone.github.io/subtitleeditor/
+// https://github.com/kitone/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "subtitlestore.h"
+#include <cstring>
+
+// Don't compact a small arena
+static const std::size_t kMinGarbage = 64 * 1024;
+
+SubtitleStore::SubtitleStore() : m_garbage(0) {
+  m_strings.push_back(std::string());
+  m_ids[std::string()] = 0;
+}
+
+void SubtitleStore::clear() {
+  m_start.clear();
+  m_end.clear();
+  m_duration.clear();
+  m_style.clear();
+  m_name.clear();
+  m_text.clear();
+  m_arena.clear();
+  m_garbage = 0;
+}
+
+unsigned int SubtitleStore::size() const {
+  return m_start.size();
+}
+
+void SubtitleStore::insert(unsigned int row) {
+  if (row > size())
+    row = size();
+
+  m_start.insert(m_start.begin() + row, 0);
+  m_end.insert(m_end.begin() + row, 0);
+  m_duration.insert(m_duration.begin() + row, 0);
+  m_style.insert(m_style.begin() + row, 0);
+  m_name.insert(m_name.begin() + row, 0);
+  m_text.insert(m_text.begin() + row, Text{0, 0});
+}
+
+void SubtitleStore::erase(unsigned int row) {
+  if (row >= size())
+    return;
+
+  m_garbage += m_text[row].length;
+
+  m_start.erase(m_start.begin() + row);
+  m_end.erase(m_end.begin() + row);
+  m_duration.erase(m_duration.begin() + row);
+  m_style.erase(m_style.begin() + row);
+  m_name.erase(m_name.begin() + row);
+  m_text.erase(m_text.begin() + row);
+
+  compact();
+}
+
+template <class T>
+static void reorder_array(std::vector<T> &array, const int *new_order) {
+  std::vector<T> tmp(array.size());
+  for (unsigned int i = 0; i < array.size(); ++i) {
+    tmp[i] = array[new_order[i]];
+  }
+  array.swap(tmp);
+}
+
+void SubtitleStore::reorder(const int *new_order, unsigned int size) {
+  if (new_order == nullptr || size != this->size())
+    return;
+
+  // Only the rows move, the texts stay in the arena
+  reorder_array(m_start, new_order);
+  reorder_array(m_end, new_order);
+  reorder_array(m_duration, new_order);
+  reorder_array(m_style, new_order);
+  reorder_array(m_name, new_order);
+  reorder_array(m_text, new_order);
+}
+
+void SubtitleStore::set_times(unsigned int row, long start, long end,
+                              long duration) {
+  if (row >= size())
+    return;
+  m_start[row] = start;
+  m_end[row] = end;
+  m_duration[row] = duration;
+}
+
+void SubtitleStore::set_style(unsigned int row, const std::string &style) {
+  if (row < size())
+    m_style[row] = intern(style);
+}
+
+void SubtitleStore::set_name(unsigned int row, const std::string &name) {
+  if (row < size())
+    m_name[row] = intern(name);
+}
+
+void SubtitleStore::set_text(unsigned int row, const std::string &text) {
+  if (row >= size() || text_equal(row, text))
+    return;
+
+  Text &t = m_text[row];
+  m_garbage += t.length;
+
+  t.offset = m_arena.size();
+  t.length = text.size();
+  m_arena.append(text);
+
+  compact();
+}
+
+const long *SubtitleStore::get_start_values() const {
+  return m_start.data();
+}
+
+const long *SubtitleStore::get_end_values() const {
+  return m_end.data();
+}
+
+const long *SubtitleStore::get_duration_values() const {
+  return m_duration.data();
+}
+
+const SubtitleStore::Id *SubtitleStore::get_style_ids() const {
+  return m_style.data();
+}
+
+const SubtitleStore::Id *SubtitleStore::get_name_ids() const {
+  return m_name.data();
+}
+
+long SubtitleStore::get_start(unsigned int row) const {
+  return m_start[row];
+}
+
+long SubtitleStore::get_end(unsigned int row) const {
+  return m_end[row];
+}
+
+long SubtitleStore::get_duration(unsigned int row) const {
+  return m_duration[row];
+}
+
+SubtitleStore::Id SubtitleStore::get_style_id(unsigned int row) const {
+  return m_style[row];
+}
+
+SubtitleStore::Id SubtitleStore::get_name_id(unsigned int row) const {
+  return m_name[row];
+}
+
+const std::string &SubtitleStore::get_string(Id id) const {
+  return m_strings[id];
+}
+
+int SubtitleStore::find_id(const std::string &str) const {
+  auto it = m_ids.find(str);
+  if (it == m_ids.end())
+    return -1;
+  return it->second;
+}
+
+const char *SubtitleStore::get_text_data(unsigned int row,
+                                         unsigned int &length) const {
+  const Text &t = m_text[row];
+  length = t.length;
+  return m_arena.data() + t.offset;
+}
+
+std::string SubtitleStore::get_text(unsigned int row) const {
+  const Text &t = m_text[row];
+  return m_arena.substr(t.offset, t.length);
+}
+
+bool SubtitleStore::text_equal(unsigned int row,
+                               const std::string &text) const {
+  const Text &t = m_text[row];
+  return t.length == text.size() &&
+         std::memcmp(m_arena.data() + t.offset, text.data(), t.length) == 0;
+}
+
+SubtitleStore::Id SubtitleStore::intern(const std::string &str) {
+  auto it = m_ids.find(str);
+  if (it != m_ids.end())
+    return it->second;
+
+  Id id = m_strings.size();
+  m_strings.push_back(str);
+  m_ids[str] = id;
+  return id;
+}
+
+void SubtitleStore::compact() {
+  if (m_garbage < kMinGarbage || m_garbage < m_arena.size() / 2)
+    return;
+
+  std::string arena;
+  arena.reserve(m_arena.size() - m_garbage);
+  for (auto &t : m_text) {
+    unsigned int offset = arena.size();
+    arena.append(m_arena, t.offset, t.length);
+    t.offset = offset;
+  }
+  m_arena.swap(arena);
+  m_garbage = 0;
+}
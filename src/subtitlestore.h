@@ -0,0 +1,126 @@
+#pragma once
+
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://kitone.github.io/subtitleeditor/
+// https://github.com/kitone/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Columnar copy of the values of the subtitles read in bulk.
+//
+// The start, end and duration values are stored in contiguous arrays (in the
+// model unit, msecs or frames), the style and the actor names are interned
+// and stored as ids, the texts are stored in a single arena. Walking the
+// whole document with the store doesn't touch the Gtk model (no GValue, no
+// string copy).
+//
+// The rows follow the structural signals of the SubtitleModel (inserted,
+// deleted, reordered), the values are written by the Subtitle setters, one
+// field at a time. The Gtk model stays the reference used by the views and
+// the commands.
+class SubtitleStore {
+ public:
+  // An interned string id. 0 is the empty string.
+  typedef unsigned int Id;
+
+  SubtitleStore();
+
+  // Remove all the rows.
+  void clear();
+
+  // Return the number of rows.
+  unsigned int size() const;
+
+  // A new empty row is inserted at the position 'row'.
+  // The following rows are shifted.
+  void insert(unsigned int row);
+
+  // The row at the position 'row' is removed.
+  // The following rows are shifted.
+  void erase(unsigned int row);
+
+  // The rows have been reordered.
+  // new_order[new_position] = old_position
+  void reorder(const int *new_order, unsigned int size);
+
+  // Update the values of the row.
+  void set_times(unsigned int row, long start, long end, long duration);
+  void set_style(unsigned int row, const std::string &style);
+  void set_name(unsigned int row, const std::string &name);
+  void set_text(unsigned int row, const std::string &text);
+
+  // Bulk accessors, size() values by array.
+  const long *get_start_values() const;
+  const long *get_end_values() const;
+  const long *get_duration_values() const;
+  const Id *get_style_ids() const;
+  const Id *get_name_ids() const;
+
+  long get_start(unsigned int row) const;
+  long get_end(unsigned int row) const;
+  long get_duration(unsigned int row) const;
+
+  Id get_style_id(unsigned int row) const;
+  Id get_name_id(unsigned int row) const;
+
+  // Return the string of an interned id.
+  const std::string &get_string(Id id) const;
+
+  // Return the id of the string or -1 if it was never interned.
+  // Allow to compare the ids instead of the strings.
+  int find_id(const std::string &str) const;
+
+  // Return the text of the row (UTF-8), valid until the next change of the
+  // store.
+  const char *get_text_data(unsigned int row, unsigned int &length) const;
+
+  std::string get_text(unsigned int row) const;
+
+  // Return true if the text of the row is the same.
+  bool text_equal(unsigned int row, const std::string &text) const;
+
+ protected:
+  Id intern(const std::string &str);
+
+  // Remove the unused bytes of the arena when they are the majority.
+  void compact();
+
+ protected:
+  struct Text {
+    unsigned int offset;
+    unsigned int length;
+  };
+
+  std::vector<long> m_start;
+  std::vector<long> m_end;
+  std::vector<long> m_duration;
+  std::vector<Id> m_style;
+  std::vector<Id> m_name;
+  std::vector<Text> m_text;
+
+  // Texts of the rows, the replaced texts are garbage until the compaction
+  std::string m_arena;
+  std::size_t m_garbage;
+
+  // Interned strings
+  std::vector<std::string> m_strings;
+  std::unordered_map<std::string, Id> m_ids;
+};
@@ -0,0 +1,276 @@
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://kitone.github.io/subtitleeditor/
+// https://github.com/kitone/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "subtitletimeindex.h"
+#include <algorithm>
+#include <climits>
+
+void SubtitleTimeIndex::clear() {
+  m_timings.clear();
+  m_sorted.clear();
+  m_max_end.clear();
+  m_min_row.clear();
+  m_leaves = 0;
+}
+
+unsigned int SubtitleTimeIndex::size() const {
+  return m_timings.size();
+}
+
+void SubtitleTimeIndex::insert(unsigned int row) {
+  if (row > m_timings.size())
+    row = m_timings.size();
+
+  m_timings.insert(m_timings.begin() + row, Timing{0, 0});
+
+  // Shifting the following rows keep the (start, row) order
+  for (auto &r : m_sorted) {
+    if (r >= row)
+      ++r;
+  }
+
+  unsigned int pos = insert_position(row);
+  m_sorted.insert(m_sorted.begin() + pos, row);
+  // The following positions are shifted and the rows before too
+  update_max_end(0, m_sorted.size() - 1);
+}
+
+void SubtitleTimeIndex::erase(unsigned int row) {
+  if (row >= m_timings.size())
+    return;
+
+  unsigned int pos = position_of(row);
+  m_sorted.erase(m_sorted.begin() + pos);
+  m_timings.erase(m_timings.begin() + row);
+
+  for (auto &r : m_sorted) {
+    if (r > row)
+      --r;
+  }
+  // The following positions and the rows are shifted, the last position is
+  // now empty
+  update_max_end(0, m_sorted.size());
+}
+
+void SubtitleTimeIndex::reorder(const int *new_order, unsigned int size) {
+  if (new_order == nullptr || size != m_timings.size())
+    return;
+
+  std::vector<Timing> timings(size);
+  for (unsigned int i = 0; i < size; ++i) {
+    timings[i] = m_timings[new_order[i]];
+  }
+  m_timings.swap(timings);
+  rebuild();
+}
+
+void SubtitleTimeIndex::assign(const long *start, const long *end,
+                               unsigned int size) {
+  m_timings.resize(size);
+  for (unsigned int i = 0; i < size; ++i) {
+    m_timings[i] = Timing{start[i], end[i]};
+  }
+  rebuild();
+}
+
+void SubtitleTimeIndex::update(unsigned int row, long start, long end) {
+  if (row >= m_timings.size())
+    return;
+
+  Timing &t = m_timings[row];
+  if (t.start == start && t.end == end)
+    return;
+
+  if (t.start == start) {
+    // The order doesn't change, only the max end
+    t.end = end;
+    unsigned int pos = position_of(row);
+    update_max_end(pos, pos);
+    return;
+  }
+
+  unsigned int old_pos = position_of(row);
+  m_sorted.erase(m_sorted.begin() + old_pos);
+
+  t.start = start;
+  t.end = end;
+
+  unsigned int new_pos = insert_position(row);
+  m_sorted.insert(m_sorted.begin() + new_pos, row);
+  update_max_end(std::min(old_pos, new_pos), std::max(old_pos, new_pos));
+}
+
+long SubtitleTimeIndex::get_start(unsigned int row) const {
+  return m_timings[row].start;
+}
+
+long SubtitleTimeIndex::get_end(unsigned int row) const {
+  return m_timings[row].end;
+}
+
+int SubtitleTimeIndex::find_first(long value) const {
+  // First position where start > value
+  auto it = std::upper_bound(
+      m_sorted.begin(), m_sorted.end(), value,
+      [this](long v, unsigned int r) { return v < m_timings[r].start; });
+
+  unsigned int limit = it - m_sorted.begin();
+  unsigned int first = UINT_MAX;
+  if (limit > 0)
+    find_first_in_tree(1, 0, m_leaves, limit, value, first);
+  return (first == UINT_MAX) ? -1 : int(first);
+}
+
+std::vector<unsigned int> SubtitleTimeIndex::find_all(long value) const {
+  return find_range(value, value);
+}
+
+std::vector<unsigned int> SubtitleTimeIndex::find_range(long from,
+                                                        long to) const {
+  std::vector<unsigned int> rows = find_unsorted(from, to);
+  std::sort(rows.begin(), rows.end());
+  return rows;
+}
+
+std::vector<unsigned int> SubtitleTimeIndex::find_unsorted(long from,
+                                                           long to) const {
+  std::vector<unsigned int> rows;
+
+  // First position where start > to
+  auto it = std::upper_bound(
+      m_sorted.begin(), m_sorted.end(), to,
+      [this](long v, unsigned int r) { return v < m_timings[r].start; });
+
+  unsigned int limit = it - m_sorted.begin();
+  if (limit > 0)
+    find_in_tree(1, 0, m_leaves, limit, from, rows);
+  return rows;
+}
+
+void SubtitleTimeIndex::find_in_tree(unsigned int node, unsigned int lo,
+                                     unsigned int hi, unsigned int limit,
+                                     long from,
+                                     std::vector<unsigned int> &rows) const {
+  if (lo >= limit || m_max_end[node] < from)
+    return;
+
+  if (node >= m_leaves) {
+    rows.push_back(m_sorted[lo]);
+    return;
+  }
+
+  unsigned int mid = (lo + hi) / 2;
+  find_in_tree(2 * node, lo, mid, limit, from, rows);
+  find_in_tree(2 * node + 1, mid, hi, limit, from, rows);
+}
+
+void SubtitleTimeIndex::find_first_in_tree(unsigned int node, unsigned int lo,
+                                           unsigned int hi, unsigned int limit,
+                                           long from,
+                                           unsigned int &first) const {
+  if (lo >= limit || m_max_end[node] < from || m_min_row[node] >= first)
+    return;
+
+  if (node >= m_leaves) {
+    first = m_sorted[lo];
+    return;
+  }
+
+  // The branch with the lowest row first, the other one is often skipped
+  unsigned int mid = (lo + hi) / 2;
+  if (m_min_row[2 * node] <= m_min_row[2 * node + 1]) {
+    find_first_in_tree(2 * node, lo, mid, limit, from, first);
+    find_first_in_tree(2 * node + 1, mid, hi, limit, from, first);
+  } else {
+    find_first_in_tree(2 * node + 1, mid, hi, limit, from, first);
+    find_first_in_tree(2 * node, lo, mid, limit, from, first);
+  }
+}
+
+unsigned int SubtitleTimeIndex::position_of(unsigned int row) const {
+  auto it = std::lower_bound(m_sorted.begin(), m_sorted.end(), row,
+                             [this](unsigned int a, unsigned int b) {
+                               long sa = m_timings[a].start;
+                               long sb = m_timings[b].start;
+                               return (sa < sb) || (sa == sb && a < b);
+                             });
+  return it - m_sorted.begin();
+}
+
+unsigned int SubtitleTimeIndex::insert_position(unsigned int row) const {
+  // The row is not (yet) in m_sorted, lower_bound give the same result
+  return position_of(row);
+}
+
+void SubtitleTimeIndex::update_max_end(unsigned int from, unsigned int until) {
+  unsigned int size = m_sorted.size();
+
+  // Grow (or shrink) the tree, everything is rebuilt
+  if (m_leaves == 0 || m_leaves < size || m_leaves > 2 * size + 1) {
+    m_leaves = 1;
+    while (m_leaves < size) {
+      m_leaves *= 2;
+    }
+    m_max_end.assign(2 * m_leaves, LONG_MIN);
+    m_min_row.assign(2 * m_leaves, UINT_MAX);
+    from = 0;
+    until = m_leaves - 1;
+  }
+
+  until = std::min(until, m_leaves - 1);
+  if (from > until)
+    return;
+
+  for (unsigned int i = from; i <= until; ++i) {
+    m_max_end[m_leaves + i] =
+        (i < size) ? m_timings[m_sorted[i]].end : LONG_MIN;
+    m_min_row[m_leaves + i] = (i < size) ? m_sorted[i] : UINT_MAX;
+  }
+
+  // Update the parents, level by level
+  unsigned int lo = (m_leaves + from) / 2;
+  unsigned int hi = (m_leaves + until) / 2;
+  while (lo >= 1) {
+    for (unsigned int i = lo; i <= hi; ++i) {
+      m_max_end[i] = std::max(m_max_end[2 * i], m_max_end[2 * i + 1]);
+      m_min_row[i] = std::min(m_min_row[2 * i], m_min_row[2 * i + 1]);
+    }
+    lo /= 2;
+    hi /= 2;
+  }
+}
+
+void SubtitleTimeIndex::rebuild() {
+  unsigned int size = m_timings.size();
+
+  m_sorted.resize(size);
+  for (unsigned int i = 0; i < size; ++i) {
+    m_sorted[i] = i;
+  }
+  std::sort(m_sorted.begin(), m_sorted.end(),
+            [this](unsigned int a, unsigned int b) {
+              long sa = m_timings[a].start;
+              long sb = m_timings[b].start;
+              return (sa < sb) || (sa == sb && a < b);
+            });
+
+  m_leaves = 0;
+  update_max_end(0, size);
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://kitone.github.io/subtitleeditor/
+// https://github.com/kitone/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include <vector>
+
+// Interval index of the subtitle timings.
+//
+// The rows are kept sorted by (start, row). A max tree (segment tree) of the
+// end values over this order allow to find every subtitle containing a time
+// with a binary search on the start, then a descent of the tree that skips
+// the branches ending before the time: O(log n) by subtitle found, even with a
+// subtitle spanning the whole document. The tree also keeps the min row of
+// each branch, find_first skips the branches that can't have a lower row.
+// The values are stored in the model unit (msecs or frames).
+//
+// The index is updated incrementally by the SubtitleModel from the row
+// signals (inserted, deleted, reordered, changed) and never touches the
+// Gtk model itself.
+class SubtitleTimeIndex {
+ public:
+  // Remove all the rows.
+  void clear();
+
+  // Return the number of rows.
+  unsigned int size() const;
+
+  // A new row (start=end=0) is inserted at the position 'row'.
+  // The following rows are shifted.
+  void insert(unsigned int row);
+
+  // The row at the position 'row' is removed.
+  // The following rows are shifted.
+  void erase(unsigned int row);
+
+  // The rows have been reordered.
+  // new_order[new_position] = old_position
+  void reorder(const int *new_order, unsigned int size);
+
+  // Replace all the rows, size values by array.
+  void assign(const long *start, const long *end, unsigned int size);
+
+  // Update the timing of the row. Does nothing if the values are the same.
+  void update(unsigned int row, long start, long end);
+
+  // Return the start value of the row.
+  long get_start(unsigned int row) const;
+
+  // Return the end value of the row.
+  long get_end(unsigned int row) const;
+
+  // Return the first row (in the document order) where start <= value <= end
+  // or -1.
+  int find_first(long value) const;
+
+  // Return all the rows where start <= value <= end, sorted by row.
+  std::vector<unsigned int> find_all(long value) const;
+
+  // Return all the rows intersecting [from, to] (start <= to and
+  // end >= from), sorted by row.
+  std::vector<unsigned int> find_range(long from, long to) const;
+
+ protected:
+  // Return the position of the row in m_sorted.
+  unsigned int position_of(unsigned int row) const;
+
+  // Return the position where the row should be inserted in m_sorted.
+  unsigned int insert_position(unsigned int row) const;
+
+  // Update the max tree (and the min row) for the positions 'from' to
+  // 'until' (included) of m_sorted.
+  void update_max_end(unsigned int from, unsigned int until);
+
+  // Add the rows of the subtree 'node' (positions [lo, hi)) with a position
+  // before 'limit' and an end >= 'from'.
+  void find_in_tree(unsigned int node, unsigned int lo, unsigned int hi,
+                    unsigned int limit, long from,
+                    std::vector<unsigned int> &rows) const;
+
+  // Set 'first' to the lowest row of the subtree 'node' (positions [lo, hi))
+  // with a position before 'limit' and an end >= 'from', if it's lower.
+  void find_first_in_tree(unsigned int node, unsigned int lo, unsigned int hi,
+                          unsigned int limit, long from,
+                          unsigned int &first) const;
+
+  // Return the rows with start <= to and end >= from, not sorted.
+  std::vector<unsigned int> find_unsorted(long from, long to) const;
+
+  // Rebuild the sorted array and the max end.
+  void rebuild();
+
+ protected:
+  struct Timing {
+    long start;
+    long end;
+  };
+
+  // Timing by row (document order)
+  std::vector<Timing> m_timings;
+  // Rows sorted by (start, row)
+  std::vector<unsigned int> m_sorted;
+  // Max tree of the end by position in m_sorted, the leaves start at
+  // m_leaves (a power of two), the node i has the children 2i and 2i+1.
+  std::vector<long> m_max_end;
+  // Min row by node of the same tree
+  std::vector<unsigned int> m_min_row;
+  unsigned int m_leaves{0};
+};
@@ -260,7 +260,6 @@ SubtitleView::SubtitleView(Document &doc) {
 
   set_rules_hint(true);
   set_enable_search(false);
-  set_search_column(m_column.num);
 
   // config
   loadCfg();
@@ -283,7 +282,28 @@ SubtitleView::SubtitleView(Document &doc) {
 
   // Update the columns size
   m_refDocument->get_signal("edit-timing-mode-changed")
-      .connect(sigc::mem_fun(*this, &Gtk::TreeView::columns_autosize));
+      .connect(
+          sigc::mem_fun(*this, &SubtitleView::on_edit_timing_mode_changed));
+
+  // Keep the render cache up to date with the model
+  m_subtitleModel->signal_row_changed().connect(
+      sigc::mem_fun(*this, &SubtitleView::on_model_row_changed));
+  m_subtitleModel->signal_row_inserted().connect(sigc::hide(sigc::hide(
+      sigc::mem_fun(*this, &SubtitleView::clear_render_cache))));
+  m_subtitleModel->signal_row_deleted().connect(
+      sigc::hide(sigc::mem_fun(*this, &SubtitleView::clear_render_cache)));
+  m_subtitleModel->signal_rows_reordered().connect(
+      sigc::hide(sigc::hide(sigc::hide(
+          sigc::mem_fun(*this, &SubtitleView::clear_render_cache)))));
+
+  // The errors aren't in the model, only the visible numbers are redrawn
+  m_refDocument->get_signal("subtitle-errors-changed")
+      .connect(sigc::mem_fun(*this, &Gtk::Widget::queue_draw));
+
+  m_refDocument->get_signal("subtitle-bulk-edit-begin")
+      .connect(sigc::mem_fun(*this, &SubtitleView::on_bulk_edit_begin));
+  m_refDocument->get_signal("subtitle-bulk-edit-end")
+      .connect(sigc::mem_fun(*this, &SubtitleView::on_bulk_edit_end));
 
   // Setup my own copy of needed timing variables
   min_duration = cfg::get_int("timing", "min-display");
@@ -317,6 +337,8 @@ void SubtitleView::on_config_timing_changed(const Glib::ustring &key,
 // Update the visible range
 // We need to update after timing change or framerate change
 void SubtitleView::update_visible_range() {
+  clear_render_cache();
+
   // tell Gtk it should update all visible rows in the subtitle list
   Gtk::TreePath cur_path, end_path;
   if (get_visible_range(cur_path, end_path)) {
@@ -328,6 +350,87 @@ void SubtitleView::update_visible_range() {
   }
 }
 
+void SubtitleView::on_bulk_edit_begin() {
+  se_dbg(SE_DBG_VIEW);
+
+  Gtk::TreePath end_path;
+  if (!get_visible_range(m_bulk_edit_top, end_path))
+    m_bulk_edit_top = Gtk::TreePath();
+
+  unset_model();
+}
+
+void SubtitleView::on_bulk_edit_end() {
+  se_dbg(SE_DBG_VIEW);
+
+  set_model(m_subtitleModel);
+
+  if (!m_bulk_edit_top.empty() &&
+      m_subtitleModel->get_iter(m_bulk_edit_top))
+    scroll_to_row(m_bulk_edit_top, 0);
+}
+
+void SubtitleView::on_edit_timing_mode_changed() {
+  clear_render_cache();
+  columns_autosize();
+}
+
+void SubtitleView::clear_render_cache() {
+  m_render_cache.clear();
+}
+
+void SubtitleView::on_model_row_changed(const Gtk::TreePath &path,
+                                        const Gtk::TreeIter & /*iter*/) {
+  unsigned int row = path[0];
+  if (row < m_render_cache.size())
+    m_render_cache[row].valid = false;
+}
+
+const SubtitleView::RowRenderCache &SubtitleView::get_render_cache(
+    const Gtk::TreeIter &iter) {
+  unsigned int row = m_subtitleModel->get_path(iter)[0];
+  if (row >= m_render_cache.size())
+    m_render_cache.resize(m_subtitleModel->children().size());
+
+  RowRenderCache &cache = m_render_cache[row];
+  if (cache.valid)
+    return cache;
+
+  Subtitle sub(m_refDocument, iter);
+
+  // Display the values in red (or blue for a cps too low) if the check timing
+  // option is enabled and if the subtitle don't respect the minimum values
+  Glib::ustring start_color, end_color, duration_color;
+  Glib::ustring cps_color("black");  // default
+
+  if (check_timing) {
+    if (sub.check_gap_before(min_gap) == false)
+      start_color = "red";
+    if (sub.check_gap_after(min_gap) == false)
+      end_color = "red";
+    if (sub.get_duration().totalmsecs < min_duration)  // duration in msec
+      duration_color = "red";
+
+    const int cmp = sub.check_cps_text(min_cps, max_cps);
+    if (cmp > 0)
+      cps_color = "red";
+    else if (cmp < 0)
+      cps_color = "blue";
+  }
+
+  cache.start = sub.convert_value_to_time_string(
+      (*iter)[m_column.start_value], start_color);
+  cache.end = sub.convert_value_to_time_string((*iter)[m_column.end_value],
+                                               end_color);
+  cache.duration = sub.convert_value_to_time_string(
+      (*iter)[m_column.duration_value], duration_color);
+  cache.cps =
+      Glib::ustring::compose("<span foreground=\"%1\">%2</span>", cps_color,
+                             sub.get_characters_per_second_text_string());
+  cache.valid = true;
+  return cache;
+}
+
 SubtitleView::~SubtitleView() {
 }
 
@@ -399,7 +502,8 @@ void SubtitleView::createColumnNum() {
   renderer->property_alignment() = Pango::ALIGN_RIGHT;
 
   column->pack_start(*renderer);
-  column->add_attribute(renderer->property_text(), m_column.num);
+  column->set_cell_data_func(
+      *renderer, sigc::mem_fun(*this, &SubtitleView::num_data_func));
 
   append_column(*column);
 
@@ -429,77 +533,45 @@ void SubtitleView::createColumnLayer() {
   // set_tooltips(column, _("Layer number."));
 }
 
-void SubtitleView::cps_data_func(const Gtk::CellRenderer *renderer,
+// Display the number in red if the live error checking has found an error.
+void SubtitleView::num_data_func(const Gtk::CellRenderer *renderer,
                                  const Gtk::TreeModel::iterator &iter) {
-  CellRendererTime *trenderer = (CellRendererTime *)renderer;
-  Subtitle cur_sub(m_refDocument, iter);
+  Gtk::CellRendererText *trenderer = (Gtk::CellRendererText *)renderer;
 
-  Glib::ustring color("black");  // default
+  unsigned int value = m_subtitleModel->get_num(iter);
+  guint errors = m_subtitleModel->get_errors(value - 1);
 
-  if (check_timing) {
-    const int cmp = cur_sub.check_cps_text(min_cps, max_cps);
-    if (cmp > 0)
-      color = "red";
-    else if (cmp < 0)
-      color = "blue";
-  }
-  trenderer->property_markup() =
-      Glib::ustring::compose("<span foreground=\"%1\">%2</span>", color,
-                             cur_sub.get_characters_per_second_text_string());
+  Glib::ustring num = to_string(value);
+
+  if (errors != 0)
+    trenderer->property_markup() =
+        Glib::ustring::compose("<span foreground=\"red\">%1</span>", num);
+  else
+    trenderer->property_text() = num;
+}
+
+void SubtitleView::cps_data_func(const Gtk::CellRenderer *renderer,
+                                 const Gtk::TreeModel::iterator &iter) {
+  CellRendererTime *trenderer = (CellRendererTime *)renderer;
+  trenderer->property_markup() = get_render_cache(iter).cps;
 }
 
 void SubtitleView::duration_data_func(const Gtk::CellRenderer *renderer,
                                       const Gtk::TreeModel::iterator &iter) {
   CellRendererTime *trenderer = (CellRendererTime *)renderer;
-  Subtitle cur_sub(m_refDocument, iter);
-
-  Glib::ustring color;
-
-  // Display text in red if the check timing option is enabled and
-  // if the current subtitle don't respect the minimum duration
-  if (check_timing) {
-    if (cur_sub.get_duration().totalmsecs < min_duration)  // duration in msec
-      color = "red";
-  }
-
-  trenderer->property_markup() = cur_sub.convert_value_to_time_string(
-      (*iter)[m_column.duration_value], color);
+  trenderer->property_markup() = get_render_cache(iter).duration;
 }
 
 void SubtitleView::start_time_data_func(const Gtk::CellRenderer *renderer,
                                         const Gtk::TreeModel::iterator &iter) {
   CellRendererTime *trenderer = (CellRendererTime *)renderer;
-  Subtitle cur_sub(m_refDocument, iter);
-
-  Glib::ustring color;
-
-  // Display text in red if the check timing option is enabled and
-  // if the current subtitle don't respect gap before subtitle
-  if (check_timing) {
-    if (cur_sub.check_gap_before(min_gap) == false)
-      color = "red";
-  }
-
-  trenderer->property_markup() = cur_sub.convert_value_to_time_string(
-      (*iter)[m_column.start_value], color);
+  trenderer->property_markup() = get_render_cache(iter).start;
 }
 
 void SubtitleView::end_time_data_func(const Gtk::CellRenderer *renderer,
                                       const Gtk::TreeModel::iterator &iter) {
   CellRendererTime *trenderer = (CellRendererTime *)renderer;
-  Subtitle cur_sub(m_refDocument, iter);
-
-  Glib::ustring color;
-
-  // Display text in red if the check timing option is enabled and
-  // if the current subtitle don't respect gap before subtitle
-  if (check_timing) {
-    if (cur_sub.check_gap_after(min_gap) == false)
-      color = "red";
-  }
-
-  trenderer->property_markup() =
-      cur_sub.convert_value_to_time_string((*iter)[m_column.end_value], color);
+  trenderer->property_markup() = get_render_cache(iter).end;
 }
 
 void SubtitleView::create_column_time(
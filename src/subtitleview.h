@@ -157,6 +157,9 @@ class SubtitleView : public Gtk::TreeView {
 
   void set_tooltips(Gtk::TreeViewColumn *column, const Glib::ustring &text);
 
+  void num_data_func(const Gtk::CellRenderer *renderer,
+                     const Gtk::TreeModel::iterator &iter);
+
   void cps_data_func(const Gtk::CellRenderer *renderer,
                      const Gtk::TreeModel::iterator &iter);
 
@@ -176,6 +179,33 @@ class SubtitleView : public Gtk::TreeView {
   // We need to update after timing change or framerate change
   void update_visible_range();
 
+  // The view is detached from the model during a bulk edit, the rows are
+  // changed without updating the view for each one.
+  void on_bulk_edit_begin();
+  void on_bulk_edit_end();
+
+  // The markup of the timing columns (start, end, duration, cps) of a row,
+  // formatted and checked once then reused by the cell data functions.
+  struct RowRenderCache {
+    bool valid{false};
+    Glib::ustring start;
+    Glib::ustring end;
+    Glib::ustring duration;
+    Glib::ustring cps;
+  };
+
+  // Return the render cache of the row, update it if needed.
+  const RowRenderCache &get_render_cache(const Gtk::TreeIter &iter);
+
+  // Forget the cache of all the rows.
+  void clear_render_cache();
+
+  // Forget the cache of the row changed.
+  void on_model_row_changed(const Gtk::TreePath &path,
+                            const Gtk::TreeIter &iter);
+
+  void on_edit_timing_mode_changed();
+
  protected:
   Document *m_refDocument;
 
@@ -190,6 +220,13 @@ class SubtitleView : public Gtk::TreeView {
 
   Gtk::Menu m_menu_popup;
 
+  // First visible row before the bulk edit
+  Gtk::TreePath m_bulk_edit_top;
+
+  // Indexed by the row, cleared when the rows are inserted, deleted or
+  // reordered.
+  std::vector<RowRenderCache> m_render_cache;
+
  protected:
   bool check_timing;
   long min_gap;
@@ -0,0 +1,86 @@
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://kitone.github.io/subtitleeditor/
+// https://github.com/kitone/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+// Randomized check of the SubtitleTimeline: a timeline walking the edges
+// during a playback (advance) must give the same active subtitles as a
+// timeline searching them from scratch (seek), and as a brute force.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "vp/subtitletimeline.h"
+
+static std::vector<unsigned int> brute_force(const std::vector<long> &start,
+                                             const std::vector<long> &end,
+                                             long time) {
+  std::vector<unsigned int> active;
+  for (unsigned int row = 0; row < start.size(); ++row) {
+    if (start[row] <= time && time < end[row])
+      active.push_back(row);
+  }
+  return active;
+}
+
+int main() {
+  srand(1);
+
+  unsigned int bad = 0;
+  for (unsigned int iteration = 0; iteration < 500; ++iteration) {
+    unsigned int size = rand() % 50;
+    std::vector<long> start(size), end(size);
+    for (unsigned int row = 0; row < size; ++row) {
+      start[row] = rand() % 10000;
+      // Some subtitles are empty or end before they start
+      end[row] = start[row] + rand() % 2000 - 200;
+    }
+
+    SubtitleTimeline playback;
+    playback.assign(start, end);
+
+    long time = 0;
+    while (time < 12000) {
+      // Mostly small steps (advance), sometimes a jump or a step back (seek)
+      int step = rand() % 20;
+      if (step == 0)
+        time += rand() % 5000;
+      else if (step == 1)
+        time = std::max(0L, time - rand() % 3000);
+      else
+        time += rand() % 100;
+
+      playback.update(time);
+
+      SubtitleTimeline seek;
+      seek.assign(start, end);
+      seek.update(time);
+
+      std::vector<unsigned int> expected = brute_force(start, end, time);
+      if (playback.get_active() != expected || seek.get_active() != expected)
+        ++bad;
+    }
+  }
+
+  if (bad > 0) {
+    printf("subtitletimeline: %u inconsistent updates\n", bad);
+    return 1;
+  }
+  return 0;
+}
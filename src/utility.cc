@@ -18,6 +18,7 @@
 // You should have received a copy of the GNU General Public License
 // along with this program. If not, see <http://www.gnu.org/licenses/>.
 
+#include <gio/gio.h>
 #include <glibmm.h>
 #include <gtkmm.h>
 #include <iostream>
@@ -260,18 +261,20 @@ double get_characters_per_second(const Glib::ustring &text, const long msecs) {
 // Count characters in a subtitle the way they need to be counted
 // for subtitle timing.
 unsigned int get_text_length_for_timing(const Glib::ustring &text) {
-  std::vector<int> num_characters = utility::get_characters_per_line(text);
-
-  if (num_characters.size() == 0)
-    return 0;
+  TextLineScanner scanner(text);
 
   unsigned int len = 0;
-
-  for (const auto &number : num_characters) {
-    len += number;
+  unsigned int lines = 0;
+  unsigned int count = 0;
+  while (scanner.next_line(count)) {
+    len += count;
+    ++lines;
   }
 
-  len += 2 * (num_characters.size() - 1);  // a newline counts as 2 characters
+  if (lines == 0)
+    return 0;
+
+  len += 2 * (lines - 1);  // a newline counts as 2 characters
   return len;
 }
 
@@ -294,29 +297,154 @@ unsigned long get_min_duration_msecs(const Glib::ustring &text, double maxcps) {
 // get number of characters for each line in the text
 std::vector<int> get_characters_per_line(const Glib::ustring &text) {
   std::vector<int> num_characters;
-  std::istringstream iss(utility::get_stripped_text(text));
-  std::string line;
 
-  while (std::getline(iss, line)) {
-    Glib::ustring::size_type len =
-        reinterpret_cast<Glib::ustring &>(line).size();
-    num_characters.push_back(len);
+  TextLineScanner scanner(text);
+  unsigned int count = 0;
+  while (scanner.next_line(count)) {
+    num_characters.push_back(count);
   }
-
   return num_characters;
 }
 
+Glib::ustring get_characters_per_line_string(const Glib::ustring &text) {
+  std::string cpl;
+
+  TextLineScanner scanner(text);
+  unsigned int count = 0;
+  while (scanner.next_line(count)) {
+    if (!cpl.empty())
+      cpl += '\n';
+    cpl += to_string(count);
+  }
+  return cpl.empty() ? Glib::ustring("0") : Glib::ustring(cpl);
+}
+
+// The spaces are ignored ("timing", "ignore-space"), read once.
+static bool get_ignore_space() {
+  static bool ignore_space = cfg::get_boolean("timing", "ignore-space");
+  return ignore_space;
+}
+
+// Return the position after the end of the tag starting at 'p' ('<' or '{'),
+// or nullptr if the tag isn't closed on the line.
+static const char *skip_tag(const char *p, const char *end) {
+  char close = (*p == '<') ? '>' : '}';
+  for (++p; p < end && *p != '\n'; ++p) {
+    if (*p == close)
+      return p + 1;
+  }
+  return nullptr;
+}
+
 // get a text stripped from tags
+// (tags like <i>, </i>, {\comment}, etc. or space)
 Glib::ustring get_stripped_text(const Glib::ustring &text) {
-  // pattern for tags like <i>, </i>, {\comment}, etc.
-  // or space
-  static bool ignore_space = cfg::get_boolean("timing", "ignore-space");
-  static Glib::RefPtr<Glib::Regex> tag_pattern =
-      ignore_space ? Glib::Regex::create("<.*?>|{.*?}| ")
-                   : Glib::Regex::create("<.*?>|{.*?}");
+  bool ignore_space = get_ignore_space();
+
+  const char *p = text.data();
+  const char *end = p + text.bytes();
+
+  std::string stripped;
+  stripped.reserve(text.bytes());
+  while (p < end) {
+    if (*p == '<' || *p == '{') {
+      const char *next = skip_tag(p, end);
+      if (next != nullptr) {
+        p = next;
+        continue;
+      }
+    } else if (ignore_space && *p == ' ') {
+      ++p;
+      continue;
+    }
+    stripped.push_back(*p++);
+  }
+  return stripped;
+}
+
+TextLineScanner::TextLineScanner(const Glib::ustring &text)
+    : m_pos(text.data()),
+      m_end(text.data() + text.bytes()),
+      m_ignore_space(get_ignore_space()) {
+}
+
+TextLineScanner::TextLineScanner(const char *begin, const char *end)
+    : m_pos(begin), m_end(end), m_ignore_space(get_ignore_space()) {
+}
 
-  return tag_pattern->replace(text, 0, "",
-                              static_cast<Glib::RegexMatchFlags>(0));
+bool TextLineScanner::next_line(unsigned int &characters) {
+  if (m_pos >= m_end)
+    return false;
+
+  characters = 0;
+  while (m_pos < m_end && *m_pos != '\n') {
+    char c = *m_pos;
+    if (c == '<' || c == '{') {
+      const char *next = skip_tag(m_pos, m_end);
+      if (next != nullptr) {
+        m_pos = next;
+        continue;
+      }
+    } else if (m_ignore_space && c == ' ') {
+      ++m_pos;
+      continue;
+    }
+    // Only the first byte of an UTF-8 character is counted
+    if ((static_cast<unsigned char>(c) & 0xC0) != 0x80)
+      ++characters;
+    ++m_pos;
+  }
+
+  // Skip the line break. Like std::getline, a last line without a line break
+  // is only a line if it isn't empty (once stripped).
+  if (m_pos < m_end)
+    ++m_pos;
+  else if (characters == 0)
+    return false;
+  return true;
+}
+
+// Run the zlib converter on all the data.
+static bool convert(GConverter *converter, const std::string &src,
+                    std::string &dst) {
+  dst.clear();
+
+  char buffer[16384];
+  const char *in = src.data();
+  gsize in_size = src.size();
+  for (;;) {
+    gsize bytes_read = 0, bytes_written = 0;
+    GError *error = nullptr;
+    GConverterResult res = g_converter_convert(
+        converter, in, in_size, buffer, sizeof(buffer),
+        G_CONVERTER_INPUT_AT_END, &bytes_read, &bytes_written, &error);
+    if (res == G_CONVERTER_ERROR) {
+      std::cerr << "convert failed: " << error->message << std::endl;
+      g_error_free(error);
+      return false;
+    }
+    in += bytes_read;
+    in_size -= bytes_read;
+    dst.append(buffer, bytes_written);
+    if (res == G_CONVERTER_FINISHED)
+      return true;
+  }
+}
+
+bool compress(const std::string &src, std::string &dst) {
+  GZlibCompressor *compressor =
+      g_zlib_compressor_new(G_ZLIB_COMPRESSOR_FORMAT_RAW, -1);
+  bool res = convert(G_CONVERTER(compressor), src, dst);
+  g_object_unref(compressor);
+  return res;
+}
+
+bool uncompress(const std::string &src, std::string &dst) {
+  GZlibDecompressor *decompressor =
+      g_zlib_decompressor_new(G_ZLIB_COMPRESSOR_FORMAT_RAW);
+  bool res = convert(G_CONVERTER(decompressor), src, dst);
+  g_object_unref(decompressor);
+  return res;
 }
 
 void set_transient_parent(Gtk::Window &window) {
@@ -149,11 +149,45 @@ unsigned long get_min_duration_msecs(const Glib::ustring &text, double maxcps);
 // get number of characters for each line in the text
 std::vector<int> get_characters_per_line(const Glib::ustring &text);
 
+// Return the number of characters of each line separated by '\n' ("12\n8"),
+// "0" for an empty text.
+Glib::ustring get_characters_per_line_string(const Glib::ustring &text);
+
 // get a text stripped from tags
 Glib::ustring get_stripped_text(const Glib::ustring &text);
 
+// Read the lines of a subtitle text (UTF-8) in a single pass and count their
+// characters, without allocation. Like get_stripped_text the tags (<...>,
+// {...}) and the spaces when "ignore-space" is set are not counted.
+//
+//  TextLineScanner scanner(text);
+//  unsigned int count;
+//  while (scanner.next_line(count))
+//    ...
+class TextLineScanner {
+ public:
+  explicit TextLineScanner(const Glib::ustring &text);
+
+  TextLineScanner(const char *begin, const char *end);
+
+  // Read the next line and return the number of characters.
+  // Return false at the end of the text.
+  bool next_line(unsigned int &characters);
+
+ protected:
+  const char *m_pos;
+  const char *m_end;
+  bool m_ignore_space;
+};
+
 void set_transient_parent(Gtk::Window &window);
 
+// Compress the data with zlib. Return false on error.
+bool compress(const std::string &src, std::string &dst);
+
+// Uncompress the data compressed by utility::compress. Return false on error.
+bool uncompress(const std::string &src, std::string &dst);
+
 Glib::ustring add_or_replace_extension(const Glib::ustring &filename,
                                        const Glib::ustring &extension);
 }  // namespace utility
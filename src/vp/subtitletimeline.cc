@@ -0,0 +1,141 @@
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://kitone.github.io/subtitleeditor/
+// https://github.com/kitone/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "subtitletimeline.h"
+#include <algorithm>
+
+// Beyond this number of edges to walk, the update is handled as a seek.
+static const unsigned int max_edges_to_walk = 16;
+
+void SubtitleTimeline::clear() {
+  m_start.clear();
+  m_end.clear();
+  m_edges.clear();
+  m_index.clear();
+  reset();
+}
+
+void SubtitleTimeline::assign(const std::vector<long> &start,
+                              const std::vector<long> &end) {
+  clear();
+
+  m_start = start;
+  m_end = end;
+
+  unsigned int size = std::min(m_start.size(), m_end.size());
+  m_start.resize(size);
+  m_end.resize(size);
+
+  // A subtitle ending before (or when) it starts is never active, it has no
+  // edge. seek() doesn't find it either.
+  m_edges.reserve(2 * size);
+  for (unsigned int row = 0; row < size; ++row) {
+    if (m_end[row] <= m_start[row])
+      continue;
+    m_edges.push_back(Edge{m_start[row], row, false});
+    m_edges.push_back(Edge{m_end[row], row, true});
+  }
+
+  // At the same time an end is passed after a start
+  std::sort(m_edges.begin(), m_edges.end(), [](const Edge &a, const Edge &b) {
+    if (a.time != b.time)
+      return a.time < b.time;
+    return a.end < b.end;
+  });
+
+  m_index.assign(m_start.data(), m_end.data(), size);
+}
+
+void SubtitleTimeline::reset() {
+  m_cursor = 0;
+  m_time = 0;
+  m_positioned = false;
+  m_active.clear();
+}
+
+bool SubtitleTimeline::update(long time) {
+  if (!m_positioned || time < m_time)
+    return seek(time);
+
+  // A jump forward
+  unsigned int next = m_cursor + max_edges_to_walk;
+  if (next < m_edges.size() && m_edges[next].time <= time)
+    return seek(time);
+
+  return advance(time);
+}
+
+const std::vector<unsigned int> &SubtitleTimeline::get_active() const {
+  return m_active;
+}
+
+bool SubtitleTimeline::is_active(unsigned int row) const {
+  return std::binary_search(m_active.begin(), m_active.end(), row);
+}
+
+bool SubtitleTimeline::has_times(unsigned int row, long start,
+                                 long end) const {
+  return row < m_start.size() && m_start[row] == start && m_end[row] == end;
+}
+
+bool SubtitleTimeline::advance(long time) {
+  m_time = time;
+
+  if (m_cursor >= m_edges.size() || m_edges[m_cursor].time > time)
+    return false;
+
+  std::vector<unsigned int> previous = m_active;
+
+  for (; m_cursor < m_edges.size() && m_edges[m_cursor].time <= time;
+       ++m_cursor) {
+    const Edge &edge = m_edges[m_cursor];
+
+    auto it = std::lower_bound(m_active.begin(), m_active.end(), edge.row);
+    if (edge.end) {
+      if (it != m_active.end() && *it == edge.row)
+        m_active.erase(it);
+    } else {
+      m_active.insert(it, edge.row);
+    }
+  }
+  return m_active != previous;
+}
+
+bool SubtitleTimeline::seek(long time) {
+  m_time = time;
+  m_positioned = true;
+
+  // Edges passed
+  m_cursor = std::upper_bound(m_edges.begin(), m_edges.end(), time,
+                              [](long v, const Edge &e) { return v < e.time; }) -
+             m_edges.begin();
+
+  // The index includes the end (start <= time <= end), not the timeline
+  std::vector<unsigned int> active;
+  for (const auto &row : m_index.find_all(time)) {
+    if (m_end[row] > time)
+      active.push_back(row);
+  }
+
+  if (active == m_active)
+    return false;
+  m_active.swap(active);
+  return true;
+}
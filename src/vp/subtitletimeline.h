@@ -0,0 +1,86 @@
+#pragma once
+
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://kitone.github.io/subtitleeditor/
+// https://github.com/kitone/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include <vector>
+#include "subtitletimeindex.h"
+
+// Timeline of the subtitles shown by the video player.
+//
+// Each subtitle gives two edges (start and end) sorted by time. During the
+// playback a cursor walks the edges to update the active subtitles, so a tick
+// only looks at the edges passed since the previous one. On a seek (backward
+// or a jump over many edges) the active subtitles are found with a
+// SubtitleTimeIndex.
+//
+// A subtitle is active when start <= time < end. The times are in msecs.
+class SubtitleTimeline {
+ public:
+  // Remove all the subtitles.
+  void clear();
+
+  // Replace the timeline, start[row] and end[row] of each subtitle.
+  void assign(const std::vector<long> &start, const std::vector<long> &end);
+
+  // Forget the position and the active subtitles, the next update searches
+  // from scratch.
+  void reset();
+
+  // Move the position to the time.
+  // Return true if the active subtitles have changed.
+  bool update(long time);
+
+  // Return the active subtitles (rows) in the document order.
+  const std::vector<unsigned int> &get_active() const;
+
+  // Return true if the subtitle is active.
+  bool is_active(unsigned int row) const;
+
+  // Return true if the row is in the timeline with these times, a change of
+  // the other values doesn't need a new timeline.
+  bool has_times(unsigned int row, long start, long end) const;
+
+ protected:
+  // Walk the edges from the cursor until the time.
+  bool advance(long time);
+
+  // Search the active subtitles and the cursor from scratch.
+  bool seek(long time);
+
+ protected:
+  struct Edge {
+    long time;
+    unsigned int row;
+    bool end;
+  };
+
+  std::vector<long> m_start;
+  std::vector<long> m_end;
+  // Edges sorted by (time, start before end)
+  std::vector<Edge> m_edges;
+  SubtitleTimeIndex m_index;
+
+  // Number of edges passed (time <= m_time)
+  unsigned int m_cursor{0};
+  long m_time{0};
+  bool m_positioned{false};
+  std::vector<unsigned int> m_active;
+};
@@ -266,6 +266,7 @@ void VideoPlayer::on_config_video_player_changed(const Glib::ustring& key,
       hide();
   } else if (key == "display-translated-subtitle") {
     m_cfg_display_translated_subtitle = utility::string_to_bool(value);
+    clear_subtitle();
   }
 }
 
@@ -273,11 +274,32 @@ void VideoPlayer::on_config_video_player_changed(const Glib::ustring& key,
 // Clear subtitle (sub and player text) and try to found the good subtitle.
 void VideoPlayer::on_active_document_changed(Document* doc) {
   m_connection_document_changed.disconnect();
-  if (doc != NULL)
+  for (auto& connection : m_connection_subtitles) {
+    connection.disconnect();
+  }
+  m_connection_subtitles.clear();
+
+  if (doc != NULL) {
     m_connection_document_changed =
         doc->get_signal("document-changed")
             .connect(sigc::mem_fun(*this, &VideoPlayer::clear_subtitle));
 
+    // A change of the rows or of the times invalidates the timeline
+    Subtitles subtitles = doc->subtitles();
+    m_connection_subtitles.push_back(subtitles.signal_changed().connect(
+        sigc::bind(sigc::mem_fun(*this, &VideoPlayer::on_subtitle_changed),
+                   doc)));
+    m_connection_subtitles.push_back(subtitles.signal_inserted().connect(
+        sigc::hide(sigc::mem_fun(*this, &VideoPlayer::on_subtitles_changed))));
+    m_connection_subtitles.push_back(subtitles.signal_deleted().connect(
+        sigc::hide(sigc::mem_fun(*this, &VideoPlayer::on_subtitles_changed))));
+    m_connection_subtitles.push_back(subtitles.signal_reordered().connect(
+        sigc::mem_fun(*this, &VideoPlayer::on_subtitles_changed)));
+  }
+
+  m_timeline.clear();
+  m_timeline_dirty = true;
+
   clear_subtitle();
   find_subtitle();
 }
@@ -288,24 +310,51 @@ void VideoPlayer::on_player_tick(long /*current_time*/, long /*stream_length*/,
   find_subtitle();
 }
 
-// Initialize the current subtitle and the player text to NULL.
+// The timeline is rebuilt on the next tick, a bulk edit of the document
+// doesn't rebuild it for each row.
+void VideoPlayer::on_subtitles_changed() {
+  m_timeline_dirty = true;
+}
+
+void VideoPlayer::on_subtitle_changed(unsigned int row, Document* doc) {
+  if (m_timeline_dirty)
+    return;
+
+  Subtitle sub = doc->subtitles().get(row + 1);
+  if (!sub || !m_timeline.has_times(row, sub.get_start().totalmsecs,
+                                    sub.get_end().totalmsecs))
+    m_timeline_dirty = true;
+  else if (m_timeline.is_active(row))
+    m_text_dirty = true;
+}
+
+// Forget the current subtitles and set the player text to NULL.
 void VideoPlayer::clear_subtitle() {
-  m_subtitle = Subtitle();
+  m_timeline.reset();
 
   m_player->set_subtitle_text("");
 }
 
-// Check if time is in subtitle.
-bool VideoPlayer::is_good_subtitle(const Subtitle& sub, long time) {
-  if (sub)
-    if (time >= sub.get_start().totalmsecs && time < sub.get_end().totalmsecs)
-      return true;
+// Rebuild the timeline from the subtitles of the document.
+void VideoPlayer::build_timeline(Document* doc) {
+  se_dbg(SE_DBG_VIDEO_PLAYER);
+
+  Subtitles subtitles = doc->subtitles();
 
-  return false;
+  std::vector<long> start, end;
+  start.reserve(subtitles.size());
+  end.reserve(subtitles.size());
+
+  for (Subtitle sub = subtitles.get_first(); sub; ++sub) {
+    start.push_back(sub.get_start().totalmsecs);
+    end.push_back(sub.get_end().totalmsecs);
+  }
+  m_timeline.assign(start, end);
+  m_timeline_dirty = false;
 }
 
-// Try to found the good subtitle and init the player (text).
-// FIXME: this's call each time
+// Update the current subtitles from the player position and init the player
+// (text) when they have changed.
 bool VideoPlayer::find_subtitle() {
   Document* doc = SubtitleEditorWindow::get_instance()->get_current_document();
   if (doc == NULL) {
@@ -313,55 +362,38 @@ bool VideoPlayer::find_subtitle() {
     return false;
   }
 
-  long position = m_player->get_position();
-
-  SubtitleTime time(position);
-
-  if (!m_subtitle) {
-    m_subtitle = doc->subtitles().find(time);
-    if (m_subtitle)
-      show_subtitle_text();
-    else
-      show_subtitle_null();
-  } else {
-    if (is_good_subtitle(m_subtitle, position)) {  // is good ?
-      show_subtitle_text();
-    } else if (time < m_subtitle.get_start()) {  // is the next ?
-      show_subtitle_null();
-    } else if (time >= m_subtitle.get_end()) {  // it's the old...
-      // ... try with the next subtitle
-      show_subtitle_null();
-
-      Subtitle next = doc->subtitles().get_next(m_subtitle);
-      if (next) {
-        m_subtitle = next;
-        if (is_good_subtitle(m_subtitle, position))
-          show_subtitle_text();
-      } else {
-        m_subtitle = Subtitle();
-      }
-    }
+  // The text of the current subtitles can be changed too, the player text is
+  // always updated after a rebuild
+  bool rebuilt = m_timeline_dirty;
+  if (rebuilt) {
+    build_timeline(doc);
+    m_timeline.reset();
   }
+
+  if (m_timeline.update(m_player->get_position()) || rebuilt || m_text_dirty)
+    show_subtitle_text(doc);
+  m_text_dirty = false;
   return true;
 }
 
-// Sets the text of the player to NULL.
-void VideoPlayer::show_subtitle_null() {
-  m_player->set_subtitle_text("");
-}
-
-// Sets the text of the player with the current subtitle.
-void VideoPlayer::show_subtitle_text() {
-  if (!m_subtitle)
-    return;
+// Sets the text of the player with the current subtitles.
+// The subtitles displayed at the same time are stacked in the document order.
+void VideoPlayer::show_subtitle_text(Document* doc) {
+  Subtitles subtitles = doc->subtitles();
 
   Glib::ustring text;
+  for (const auto& row : m_timeline.get_active()) {
+    Subtitle sub = subtitles.get(row + 1);
+    if (!sub)
+      continue;
 
-  if (m_cfg_display_translated_subtitle &&
-      !m_subtitle.get_translation().empty())
-    text = m_subtitle.get_translation();
-  else
-    text = m_subtitle.get_text();
+    if (!text.empty())
+      text += "\n";
 
+    if (m_cfg_display_translated_subtitle && !sub.get_translation().empty())
+      text += sub.get_translation();
+    else
+      text += sub.get_text();
+  }
   m_player->set_subtitle_text(text);
 }
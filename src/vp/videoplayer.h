@@ -22,6 +22,7 @@
 
 #include <gtkmm.h>
 #include "player.h"
+#include "subtitletimeline.h"
 
 class VideoPlayer : public Gtk::VBox {
  public:
@@ -55,25 +56,37 @@ class VideoPlayer : public Gtk::VBox {
   void on_player_tick(long current_time, long stream_length,
                       double current_position);
 
-  // Initialize the current subtitle and the player text to NULL.
+  // The subtitles of the document have changed, the timeline needs to be
+  // rebuilt.
+  void on_subtitles_changed();
+
+  // A value of the subtitle has changed, the timeline is only rebuilt if
+  // it's a time. The text is updated if the subtitle is displayed.
+  void on_subtitle_changed(unsigned int row, Document* doc);
+
+  // Forget the current subtitles and set the player text to NULL.
   void clear_subtitle();
 
-  // Check if time is in subtitle.
-  bool is_good_subtitle(const Subtitle& sub, long time);
+  // Rebuild the timeline from the subtitles of the document.
+  void build_timeline(Document* doc);
 
-  // Try to found the good subtitle and init the player (text).
+  // Update the current subtitles from the player position and init the player
+  // (text) when they have changed.
   bool find_subtitle();
 
-  // Sets the text of the player to NULL.
-  void show_subtitle_null();
-
-  // Sets the text of the player with the current subtitle.
-  void show_subtitle_text();
+  // Sets the text of the player with the current subtitles.
+  void show_subtitle_text(Document* doc);
 
  protected:
   sigc::connection m_connection_document_changed;
-  Subtitle m_subtitle;
+  std::vector<sigc::connection> m_connection_subtitles;
   Player* m_player;
 
+  // The timeline of the current document, rebuilt when it's dirty
+  SubtitleTimeline m_timeline;
+  bool m_timeline_dirty{true};
+  // A displayed subtitle has changed (text)
+  bool m_text_dirty{false};
+
   bool m_cfg_display_translated_subtitle;
 };
@@ -18,11 +18,50 @@
 // You should have received a copy of the GNU General Public License
 // along with this program. If not, see <http://www.gnu.org/licenses/>.
 
+#include <glib/gstdio.h>
 #include <math.h>
+#include <string.h>
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include "debug.h"
 #include "waveform.h"
 
+// The magic line of the v3 format
+static const char WAVEFORM_V3_MAGIC[] = "waveform v3\n";
+static const gsize WAVEFORM_V3_MAGIC_SIZE = sizeof(WAVEFORM_V3_MAGIC) - 1;
+// magic + 4 * guint32 + 3 * 64 bits + guint32
+static const gsize WAVEFORM_V3_FIXED_HEADER_SIZE =
+    WAVEFORM_V3_MAGIC_SIZE + 4 * 4 + 3 * 8 + 4;
+
+// Little-endian helpers for the v3 format
+static guint32 read_le32(const gchar *data) {
+  guint32 value;
+  memcpy(&value, data, sizeof(value));
+  return GUINT32_FROM_LE(value);
+}
+
+static guint64 read_le64(const gchar *data) {
+  guint64 value;
+  memcpy(&value, data, sizeof(value));
+  return GUINT64_FROM_LE(value);
+}
+
+static void write_le32(std::ofstream &file, guint32 value) {
+  value = GUINT32_TO_LE(value);
+  file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+static void write_le64(std::ofstream &file, guint64 value) {
+  value = GUINT64_TO_LE(value);
+  file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+// Number of entries of the level of the pyramid.
+static guint64 level_size(guint64 size, guint level) {
+  return (size + (G_GUINT64_CONSTANT(1) << level) - 1) >> level;
+}
+
 // Open Wavefrom from file
 Glib::RefPtr<Waveform> Waveform::create_from_file(const Glib::ustring &uri) {
   Glib::RefPtr<Waveform> wf = Glib::RefPtr<Waveform>(new Waveform);
@@ -42,6 +81,7 @@ Waveform::Waveform() {
 }
 
 Waveform::~Waveform() {
+  close_mapped_file();
 }
 
 void Waveform::reference() const {
@@ -54,6 +94,8 @@ void Waveform::unreference() const {
 }
 
 guint Waveform::get_size() {
+  if (m_mapped_file)
+    return m_mapped_size;
   return m_channels[0].size();
 }
 
@@ -62,9 +104,15 @@ gint64 Waveform::get_duration() {
 }
 
 double Waveform::get_channel(unsigned int ch, guint64 pos) {
-  pos = CLAMP(pos, 0, get_size());
-  ch = CLAMP(ch, 0, m_n_channels);
+  guint size = get_size();
+  if (size == 0 || m_n_channels == 0)
+    return 0.0;
+
+  pos = CLAMP(pos, 0, size - 1);
+  ch = CLAMP(ch, 0, m_n_channels - 1);
 
+  if (m_mapped_file)
+    return get_mapped_sample(m_mapped_channels[ch], pos);
   return m_channels[ch][pos];
 }
 
@@ -72,6 +120,137 @@ unsigned int Waveform::get_n_channels() {
   return m_n_channels;
 }
 
+double Waveform::get_sample_rate() {
+  if (m_mapped_file)
+    return m_mapped_sample_rate;
+  if (m_duration <= 0)
+    return 0.0;
+  return get_size() * 1000.0 / m_duration;
+}
+
+guint Waveform::get_n_levels() {
+  if (m_mapped_file && !m_mapped_levels[0].empty())
+    return m_mapped_levels[0].size();
+
+  build_levels();
+  return m_levels[0].size();
+}
+
+guint64 Waveform::get_level_size(guint level) {
+  return level_size(get_size(), level);
+}
+
+guint Waveform::get_level_for_samples_per_pixel(double samples_per_pixel) {
+  guint level = 0;
+  guint n_levels = get_n_levels();
+  while (level < n_levels &&
+         (G_GUINT64_CONSTANT(2) << level) <= samples_per_pixel) {
+    ++level;
+  }
+  return level;
+}
+
+void Waveform::get_level_peak(unsigned int ch, guint level, guint64 index,
+                              double &min, double &max) {
+  if (level == 0) {
+    min = max = get_channel(ch, index);
+    return;
+  }
+
+  guint n_levels = get_n_levels();
+  if (n_levels == 0 || m_n_channels == 0) {
+    min = max = 0.0;
+    return;
+  }
+
+  level = CLAMP(level, 1, n_levels);
+  ch = CLAMP(ch, 0, m_n_channels - 1);
+  index = CLAMP(index, 0, get_level_size(level) - 1);
+
+  if (m_mapped_file && !m_mapped_levels[ch].empty()) {
+    const guint8 *data = m_mapped_levels[ch][level - 1];
+    min = get_mapped_sample(data, index * 2);
+    max = get_mapped_sample(data, index * 2 + 1);
+  } else {
+    const std::vector<float> &data = m_levels[ch][level - 1];
+    min = data[index * 2];
+    max = data[index * 2 + 1];
+  }
+}
+
+void Waveform::get_peak(unsigned int ch, guint64 start, guint64 end,
+                        double &min, double &max) {
+  guint64 size = get_size();
+  end = std::min(end, size);
+  if (start >= end) {
+    min = max = get_channel(ch, start);
+    return;
+  }
+
+  guint n_levels = get_n_levels();
+
+  min = 1.0;
+  max = 0.0;
+  while (start < end) {
+    // The largest level aligned on start and not after end
+    guint level = 0;
+    while (level < n_levels) {
+      guint64 next = G_GUINT64_CONSTANT(1) << (level + 1);
+      if ((start & (next - 1)) != 0 || start + next > end)
+        break;
+      ++level;
+    }
+
+    double lmin, lmax;
+    get_level_peak(ch, level, start >> level, lmin, lmax);
+    min = std::min(min, lmin);
+    max = std::max(max, lmax);
+
+    start += G_GUINT64_CONSTANT(1) << level;
+  }
+}
+
+void Waveform::invalidate_levels() {
+  for (guint ch = 0; ch < 3; ++ch) {
+    m_levels[ch].clear();
+  }
+}
+
+void Waveform::build_levels() {
+  if (!m_levels[0].empty() || m_n_channels == 0)
+    return;
+
+  const guint64 size = get_size();
+
+  for (guint ch = 0; ch < m_n_channels; ++ch) {
+    for (guint l = 1; level_size(size, l - 1) > 1; ++l) {
+      guint64 lsize = level_size(size, l);
+      std::vector<float> level(lsize * 2);
+      for (guint64 i = 0; i < lsize; ++i) {
+        double amin, amax, bmin, bmax;
+        guint64 a = i * 2;
+        guint64 b = std::min(a + 1, level_size(size, l - 1) - 1);
+        if (l == 1) {
+          amin = amax = get_channel(ch, a);
+          bmin = bmax = get_channel(ch, b);
+        } else {
+          const std::vector<float> &prev = m_levels[ch].back();
+          amin = prev[a * 2];
+          amax = prev[a * 2 + 1];
+          bmin = prev[b * 2];
+          bmax = prev[b * 2 + 1];
+        }
+        level[i * 2] = std::min(amin, bmin);
+        level[i * 2 + 1] = std::max(amax, bmax);
+      }
+      m_levels[ch].push_back(level);
+    }
+  }
+
+  se_dbg_msg(SE_DBG_WAVEFORM, "pyramid built: %d levels",
+             static_cast<int>(m_levels[0].size()));
+}
+
 bool Waveform::open(const Glib::ustring &file_uri) {
   Glib::ustring filename = Glib::filename_from_uri(file_uri);
 
@@ -83,6 +262,33 @@ bool Waveform::open(const Glib::ustring &file_uri) {
 
   std::string line;
 
+  if (!std::getline(file, line)) {
+    file.close();
+    return false;
+  }
+  file.close();
+
+  bool res = false;
+  if (line == "waveform v3")
+    res = open_v3(filename);
+  else if (line == "waveform" || line == "waveform v2")
+    res = open_v1_v2(filename);
+
+  if (res)
+    m_waveform_uri = file_uri;
+
+  return res;
+}
+
+bool Waveform::open_v1_v2(const Glib::ustring &filename) {
+  std::ifstream file(filename.c_str(), std::ios_base::binary);
+
+  if (!file) {
+    return false;
+  }
+
+  std::string line;
+
   if (!std::getline(file, line)) {
     file.close();
     return false;
@@ -106,6 +312,8 @@ bool Waveform::open(const Glib::ustring &file_uri) {
 
   m_video_uri = line;
 
+  invalidate_levels();
+
   file.read((char *)&m_n_channels, sizeof(m_n_channels));
   file.read((char *)&m_duration, sizeof(m_duration));
 
@@ -113,6 +321,11 @@ bool Waveform::open(const Glib::ustring &file_uri) {
     m_duration = m_duration / 1000000;  // GST_MSECOND=1000000;
   }
 
+  if (m_n_channels > 3) {
+    file.close();
+    return false;
+  }
+
   for (unsigned int n = 0; n < m_n_channels; ++n) {
     std::vector<double>::size_type size = 0;
 
@@ -120,45 +333,254 @@ bool Waveform::open(const Glib::ustring &file_uri) {
 
     m_channels[n].resize(size);
 
-    for (unsigned int i = 0; i < size; ++i) {
-      file.read((char *)&m_channels[n][i], sizeof(double));
-    }
+    // The samples are contiguous, read the whole channel at once
+    file.read((char *)m_channels[n].data(), size * sizeof(double));
   }
 
+  bool res = !file.fail();
+
   file.close();
 
-  m_waveform_uri = file_uri;
+  return res;
+}
+
+bool Waveform::open_v3(const Glib::ustring &filename) {
+  GError *error = NULL;
+  GMappedFile *mapped = g_mapped_file_new(filename.c_str(), FALSE, &error);
+  if (mapped == NULL) {
+    std::cerr << "Could not map the waveform file: " << error->message
+              << std::endl;
+    g_error_free(error);
+    return false;
+  }
+
+  const gchar *data = g_mapped_file_get_contents(mapped);
+  const guint64 length = g_mapped_file_get_length(mapped);
+
+  if (length < WAVEFORM_V3_FIXED_HEADER_SIZE ||
+      memcmp(data, WAVEFORM_V3_MAGIC, WAVEFORM_V3_MAGIC_SIZE) != 0) {
+    g_mapped_file_unref(mapped);
+    return false;
+  }
+
+  const gchar *header = data + WAVEFORM_V3_MAGIC_SIZE;
+  guint32 header_size = read_le32(header);
+  guint32 n_channels = read_le32(header + 4);
+  guint32 bits_per_sample = read_le32(header + 8);
+  guint32 n_levels = read_le32(header + 12);
+  guint64 size = read_le64(header + 16);
+  gint64 duration = static_cast<gint64>(read_le64(header + 24));
+  guint64 rate_bits = read_le64(header + 32);
+  guint32 uri_length = read_le32(header + 40);
+
+  double sample_rate;
+  memcpy(&sample_rate, &rate_bits, sizeof(sample_rate));
+
+  if (size > length || n_levels > 63) {
+    std::cerr << "The waveform file '" << filename << "' is corrupted"
+              << std::endl;
+    g_mapped_file_unref(mapped);
+    return false;
+  }
+
+  guint64 bytes_per_sample = bits_per_sample / 8;
+
+  // Check the header before using any offset
+  guint64 expected = header_size;
+  for (guint l = 1; l <= n_levels; ++l) {
+    expected += n_channels * level_size(size, l) * 2 * bytes_per_sample;
+  }
+  expected += n_channels * size * bytes_per_sample;
+
+  if (n_channels == 0 || n_channels > 3 ||
+      (bits_per_sample != 8 && bits_per_sample != 16) ||
+      header_size % 8 != 0 ||
+      header_size < WAVEFORM_V3_FIXED_HEADER_SIZE + uri_length ||
+      expected > length) {
+    std::cerr << "The waveform file '" << filename << "' is corrupted"
+              << std::endl;
+    g_mapped_file_unref(mapped);
+    return false;
+  }
+
+  close_mapped_file();
+  invalidate_levels();
+
+  m_mapped_file = mapped;
+  m_mapped_bits_per_sample = bits_per_sample;
+  m_mapped_size = size;
+  m_mapped_sample_rate = sample_rate;
+
+  m_n_channels = n_channels;
+  m_duration = duration;
+  m_video_uri = std::string(data + WAVEFORM_V3_FIXED_HEADER_SIZE, uri_length);
+
+  const guint8 *samples = reinterpret_cast<const guint8 *>(data) + header_size;
+  for (guint ch = 0; ch < n_channels; ++ch) {
+    m_channels[ch].clear();
+    m_mapped_channels[ch] = samples;
+    samples += size * bytes_per_sample;
+  }
+  for (guint ch = 0; ch < n_channels; ++ch) {
+    m_mapped_levels[ch].resize(n_levels);
+    for (guint l = 1; l <= n_levels; ++l) {
+      m_mapped_levels[ch][l - 1] = samples;
+      samples += level_size(size, l) * 2 * bytes_per_sample;
+    }
+  }
 
+  se_dbg_msg(SE_DBG_WAVEFORM,
+             "waveform v3 mapped: channels=%d samples=%lu bits=%d levels=%d",
+             n_channels, static_cast<gulong>(size), bits_per_sample, n_levels);
   return true;
 }
 
+void Waveform::close_mapped_file() {
+  if (m_mapped_file == nullptr)
+    return;
+
+  g_mapped_file_unref(m_mapped_file);
+  m_mapped_file = nullptr;
+  m_mapped_size = 0;
+  for (guint ch = 0; ch < 3; ++ch) {
+    m_mapped_channels[ch] = nullptr;
+    m_mapped_levels[ch].clear();
+  }
+}
+
+double Waveform::get_mapped_sample(const guint8 *data, guint64 pos) const {
+  if (m_mapped_bits_per_sample == 8)
+    return data[pos] / 255.0;
+
+  guint16 value;
+  memcpy(&value, data + pos * 2, sizeof(value));
+  return GUINT16_FROM_LE(value) / 65535.0;
+}
+
 bool Waveform::save(const Glib::ustring &file_uri) {
+  return save(file_uri, 16, true);
+}
+
+bool Waveform::save(const Glib::ustring &file_uri, guint bits_per_sample,
+                    bool with_pyramid) {
+  g_return_val_if_fail(bits_per_sample == 8 || bits_per_sample == 16, false);
+
   Glib::ustring filename = Glib::filename_from_uri(file_uri);
 
-  std::ofstream file(filename.c_str(), std::ios_base::binary);
+  // Quantize the peaks
+  const guint64 size = get_size();
+  const double max_value = (bits_per_sample == 8) ? 255.0 : 65535.0;
 
-  if (!file)
-    return false;
+  std::vector<guint16> samples[3];
+  for (guint ch = 0; ch < m_n_channels; ++ch) {
+    samples[ch].resize(size);
+    for (guint64 i = 0; i < size; ++i) {
+      double value = CLAMP(get_channel(ch, i), 0.0, 1.0);
+      samples[ch][i] = static_cast<guint16>(lround(value * max_value));
+    }
+  }
+
+  // Quantize the min/max pyramid
+  std::vector<std::vector<guint16> > levels[3];
+  if (with_pyramid) {
+    guint n_levels = get_n_levels();
+    for (guint ch = 0; ch < m_n_channels; ++ch) {
+      levels[ch].resize(n_levels);
+      for (guint l = 1; l <= n_levels; ++l) {
+        guint64 lsize = get_level_size(l);
+        std::vector<guint16> &level = levels[ch][l - 1];
+        level.resize(lsize * 2);
+        for (guint64 i = 0; i < lsize; ++i) {
+          double min, max;
+          get_level_peak(ch, l, i, min, max);
+          level[i * 2] = static_cast<guint16>(lround(min * max_value));
+          level[i * 2 + 1] = static_cast<guint16>(lround(max * max_value));
+        }
+      }
+    }
+  }
 
-  file << "waveform v2" << std::endl;
+  guint32 n_levels = levels[0].size();
+  std::string video_uri = m_video_uri.raw();
+  gint64 duration = m_duration;
+  double sample_rate = get_sample_rate();
 
-  file << m_video_uri << std::endl;
+  // Write in a temporary file, the destination can be the mapped file
+  std::string tmp_filename = filename + ".tmp";
 
-  file.write((const char *)&m_n_channels, sizeof(m_n_channels));
-  file.write((const char *)&m_duration, sizeof(m_duration));
+  std::ofstream file(tmp_filename.c_str(), std::ios_base::binary);
 
-  for (unsigned int n = 0; n < m_n_channels; ++n) {
-    std::vector<double>::size_type size = m_channels[n].size();
+  if (!file)
+    return false;
 
-    file.write((const char *)&size, sizeof(size));
+  guint32 header_size = WAVEFORM_V3_FIXED_HEADER_SIZE + video_uri.size();
+  header_size = (header_size + 7) & ~7u;
+
+  guint64 rate_bits;
+  memcpy(&rate_bits, &sample_rate, sizeof(rate_bits));
+
+  file.write(WAVEFORM_V3_MAGIC, WAVEFORM_V3_MAGIC_SIZE);
+  write_le32(file, header_size);
+  write_le32(file, m_n_channels);
+  write_le32(file, bits_per_sample);
+  write_le32(file, n_levels);
+  write_le64(file, size);
+  write_le64(file, static_cast<guint64>(duration));
+  write_le64(file, rate_bits);
+  write_le32(file, video_uri.size());
+  file.write(video_uri.data(), video_uri.size());
+
+  // padding
+  guint32 padding =
+      header_size - WAVEFORM_V3_FIXED_HEADER_SIZE - video_uri.size();
+  const char zeros[8] = {0};
+  file.write(zeros, padding);
+
+  auto write_samples = [&](const std::vector<guint16> &values) {
+    if (bits_per_sample == 8) {
+      std::vector<guint8> buf(values.begin(), values.end());
+      file.write(reinterpret_cast<const char *>(buf.data()), buf.size());
+    } else {
+      std::vector<guint16> buf(values.size());
+      for (gsize i = 0; i < values.size(); ++i) {
+        buf[i] = GUINT16_TO_LE(values[i]);
+      }
+      file.write(reinterpret_cast<const char *>(buf.data()), buf.size() * 2);
+    }
+  };
 
-    for (unsigned int i = 0; i < size; ++i) {
-      file.write((const char *)&m_channels[n][i], sizeof(double));
+  for (guint ch = 0; ch < m_n_channels; ++ch) {
+    write_samples(samples[ch]);
+  }
+  for (guint ch = 0; ch < m_n_channels; ++ch) {
+    for (const auto &level : levels[ch]) {
+      write_samples(level);
     }
   }
 
+  bool res = !file.fail();
   file.close();
 
+  if (!res) {
+    g_remove(tmp_filename.c_str());
+    return false;
+  }
+
+  bool was_mapped = (m_mapped_file != nullptr);
+  // The mapped file must be released before replacing it
+  close_mapped_file();
+
+  if (g_rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+    g_remove(tmp_filename.c_str());
+    if (was_mapped)
+      open_v3(filename);
+    return false;
+  }
+
+  // The samples are still in the new file
+  if (was_mapped && !open_v3(filename))
+    return false;
+
   m_waveform_uri = file_uri;
 
   return true;
@@ -23,6 +23,27 @@
 #include <glibmm.h>
 #include <vector>
 
+// A Waveform is the RMS peaks of the audio channels (max 3), the values are
+// between 0 and 1.
+//
+// The peaks are either in memory (m_channels) when the waveform is generated
+// or read from a v1/v2 file, or directly in a memory mapped file when the
+// waveform is read from a v3 file.
+//
+// Waveform v3 file format (little-endian):
+//  "waveform v3\n"
+//  guint32 header size (offset of the samples, aligned on 8 bytes)
+//  guint32 number of channels
+//  guint32 bits per sample (8 or 16)
+//  guint32 number of levels of the min/max pyramid (0 = none)
+//  guint64 number of samples per channel
+//  gint64  duration (msecs)
+//  double  sample rate (samples per second)
+//  guint32 length of the video uri
+//  the video uri and a padding to the header size
+//  the samples of each channel (quantized peaks)
+//  for each channel, the levels [1, n] of the pyramid. The level l has
+//  ceil(samples / 2^l) pairs of quantized (min, max).
 class Waveform {
  public:
   Waveform();
@@ -41,10 +62,47 @@ class Waveform {
 
   unsigned int get_n_channels();
 
+  // Return the number of samples per second.
+  double get_sample_rate();
+
+  // Min/max pyramid (mipmap) of the peaks.
+  // The level 0 is the samples, the entry i of the level l is the min and the
+  // max of the samples [i * 2^l, (i + 1) * 2^l). The pyramid is read from the
+  // v3 file if available, otherwise it's built once on the first use.
+
+  // Return the number of levels (without the level 0).
+  guint get_n_levels();
+
+  // Return the number of entries of the level.
+  guint64 get_level_size(guint level);
+
+  // Return the level matching the number of samples displayed by pixel.
+  guint get_level_for_samples_per_pixel(double samples_per_pixel);
+
+  // Return the min and the max of the entry of the level.
+  void get_level_peak(unsigned int channel, guint level, guint64 index,
+                      double &min, double &max);
+
+  // Return the min and the max of the samples [start, end) by using the
+  // largest levels of the pyramid, O(log n).
+  void get_peak(unsigned int channel, guint64 start, guint64 end, double &min,
+                double &max);
+
+  // Drop the pyramid built from the samples.
+  // Need to be called when the samples (m_channels) are modified.
+  void invalidate_levels();
+
   bool open(const Glib::ustring &uri);
 
+  // Save the waveform in the v3 format with 16 bits samples and the min/max
+  // pyramid.
   bool save(const Glib::ustring &uri);
 
+  // Save the waveform in the v3 format.
+  // bits_per_sample is 8 or 16.
+  bool save(const Glib::ustring &uri, guint bits_per_sample,
+            bool with_pyramid);
+
   // l'uri de la video source du waveform
   Glib::ustring get_video_uri();
 
@@ -53,6 +111,23 @@ class Waveform {
   void reference() const;
   void unreference() const;
 
+ protected:
+  // Read the v1 and v2 format (doubles).
+  bool open_v1_v2(const Glib::ustring &filename);
+
+  // Map the v3 file in memory.
+  bool open_v3(const Glib::ustring &filename);
+
+  // Release the mapped file.
+  void close_mapped_file();
+
+  // Return the quantized sample at the position.
+  double get_mapped_sample(const guint8 *data, guint64 pos) const;
+
+  // Build the pyramid from the samples if there's none.
+  void build_levels();
+
+ public:
   // protected:
 
   Glib::ustring m_waveform_uri;
@@ -63,4 +138,16 @@ class Waveform {
 
  protected:
   mutable int ref_count_{0};
+
+  // v3 memory mapped file
+  GMappedFile *m_mapped_file{nullptr};
+  guint m_mapped_bits_per_sample{16};
+  guint64 m_mapped_size{0};
+  double m_mapped_sample_rate{0};
+  const guint8 *m_mapped_channels[3]{nullptr, nullptr, nullptr};
+  // The pyramid levels [1, n] stored in the file
+  std::vector<const guint8 *> m_mapped_levels[3];
+
+  // The pyramid levels [1, n] built from the samples, (min, max) pairs
+  std::vector<std::vector<float> > m_levels[3];
 };
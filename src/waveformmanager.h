@@ -35,6 +35,10 @@ class WaveformManager {
   // Init the Waveform Editor and the WaveformRenderer with this wf
   virtual void set_waveform(const Glib::RefPtr<Waveform> &wf) = 0;
 
+  // The samples of the current waveform have changed (generation in
+  // progress), redisplay the waveform.
+  virtual void update_waveform() = 0;
+
   // Return the state of waveform. Cab be NULL.
   virtual bool has_waveform() = 0;
 
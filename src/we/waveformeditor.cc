@@ -169,9 +169,21 @@ void WaveformEditor::init_document(Document *doc) {
     CONNECT("document-changed", on_document_changed);
     CONNECT("subtitle-selection-changed", on_subtitle_selection_changed);
     CONNECT("subtitle-time-changed", on_subtitle_time_changed);
+    CONNECT("subtitle-errors-changed", on_subtitle_errors_changed);
 
 #undef CONNECT
 
+    Subtitles subtitles = doc->subtitles();
+    m_document_connection.push_back(subtitles.signal_changed().connect(
+        sigc::hide(
+            sigc::mem_fun(*this, &WaveformEditor::on_subtitles_changed))));
+    m_document_connection.push_back(subtitles.signal_inserted().connect(
+        sigc::hide(
+            sigc::mem_fun(*this, &WaveformEditor::on_subtitles_changed))));
+    m_document_connection.push_back(subtitles.signal_deleted().connect(
+        sigc::hide(
+            sigc::mem_fun(*this, &WaveformEditor::on_subtitles_changed))));
+
     init_scrollbar();
   }
 
@@ -298,7 +310,9 @@ void WaveformEditor::on_player_tick(long /*current_time*/,
 	if(!((subtitle_start_and_end_times.first <= playerpos) && (subtitle_start_and_end_times.second >= playerpos))) {
 		subtitle_start_and_end_times = select_with_player();
 		}
-    redraw_renderer();
+    // A change of the scrolling or of the selection has already redrawn
+    // everything, here only the player position is updated
+    renderer()->player_position_changed();
   }
 }
 
@@ -474,6 +488,14 @@ void WaveformEditor::set_waveform(const Glib::RefPtr<Waveform> &wf) {
   redraw_renderer();
 }
 
+// The samples of the current waveform have changed (generation in progress).
+void WaveformEditor::update_waveform() {
+  se_dbg(SE_DBG_WAVEFORM);
+
+  if (has_renderer())
+    renderer()->waveform_changed();
+}
+
 // Return the state of waveform. Can be NULL.
 bool WaveformEditor::has_waveform() {
   return static_cast<bool>(get_waveform());
@@ -548,6 +570,26 @@ void WaveformEditor::on_subtitle_time_changed() {
   redraw_renderer();
 }
 
+// This callback is connected at the current document.
+// The errors found by the live error checking have changed, it's need to
+// redraw the view.
+void WaveformEditor::on_subtitle_errors_changed() {
+  if ((has_renderer() && has_waveform()) == false)
+    return;
+
+  redraw_renderer();
+}
+
+// This callback is connected at the model of the current document.
+// A row has changed (text, style...), the renderer keeps the subtitles
+// drawn, it's need to redraw the view.
+void WaveformEditor::on_subtitles_changed() {
+  if ((has_renderer() && has_waveform()) == false)
+    return;
+
+  redraw_renderer();
+}
+
 // This callback is connected at the player.
 // The keyframes has changed, it's need to redraw the view.
 void WaveformEditor::on_player_message(Player::Message msg) {
@@ -39,6 +39,9 @@ class WaveformEditor : public WaveformManager, public Gtk::Box {
   // Init the Waveform Editor and the WaveformRenderer with this wf
   void set_waveform(const Glib::RefPtr<Waveform>& wf);
 
+  // The samples of the current waveform have changed.
+  void update_waveform();
+
   // Return the state of waveform. Cab be NULL.
   bool has_waveform();
 
@@ -188,6 +191,16 @@ class WaveformEditor : public WaveformManager, public Gtk::Box {
   // The time of subtitle has changed, it's need to redraw the view.
   void on_subtitle_time_changed();
 
+  // This callback is connected at the current document.
+  // The errors found by the live error checking have changed, it's need to
+  // redraw the view.
+  void on_subtitle_errors_changed();
+
+  // This callback is connected at the model of the current document.
+  // A row has changed (text, style...), the renderer keeps the subtitles
+  // drawn, it's need to redraw the view.
+  void on_subtitles_changed();
+
   // This callback is connected at the player.
   // The keyframes has changed, it's need to redraw the view.
   void on_player_message(Player::Message msg);
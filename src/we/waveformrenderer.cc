@@ -124,6 +124,10 @@ void WaveformRenderer::redraw_all() {
 void WaveformRenderer::force_redraw_all() {
 }
 
+void WaveformRenderer::player_position_changed() {
+  redraw_all();
+}
+
 int WaveformRenderer::get_start_area() {
   return scrolling();
 }
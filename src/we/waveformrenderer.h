@@ -47,6 +47,10 @@ class WaveformRenderer {
 
   virtual void force_redraw_all();
 
+  // Only the position of the player has changed.
+  // By default everything is redrawn.
+  virtual void player_position_changed();
+
   int get_start_area();
 
   int get_end_area();
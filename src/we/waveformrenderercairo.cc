@@ -18,6 +18,7 @@
 // You should have received a copy of the GNU General Public License
 // along with this program. If not, see <http://www.gnu.org/licenses/>.
 
+#include <algorithm>
 #include "document.h"
 #include "keyframes.h"
 #include "player.h"
@@ -54,13 +55,29 @@ class WaveformRendererCairo : public Gtk::DrawingArea, public WaveformRenderer {
   // Delete the surface and redraw
   void force_redraw_all();
 
+  // Only redraw the strips of the old and the new position.
+  void player_position_changed();
+
   bool on_configure_event(GdkEventConfigure *ev);
 
+  // Remove all the cached layers.
+  void clear_layers();
+
+  // Return a new transparent layer compatible with the target.
+  Cairo::RefPtr<Cairo::Surface> create_layer(
+      const Cairo::RefPtr<Cairo::Context> &cr, int width, int height);
+
+  // Paint the layer on the context at the position.
+  void paint_layer(const Cairo::RefPtr<Cairo::Context> &cr,
+                   const Cairo::RefPtr<Cairo::Surface> &layer, int x, int y);
+
   // Display all scene:
   // - timeline (draw_timeline)
   // - waveform (draw_waveform)
   // - subtitle (draw_subtitles)
   // - time info (display_time_info)
+  // The timeline, the waveform, the keyframes and the subtitles are cached
+  // layers, only drawn again when they are invalid.
   bool on_draw(const Cairo::RefPtr<Cairo::Context> &cr);
 
   // Display all of timeline: Time, seconds
@@ -90,6 +107,11 @@ class WaveformRendererCairo : public Gtk::DrawingArea, public WaveformRenderer {
   void draw_subtitle_text(const Cairo::RefPtr<Cairo::Context> &cr,
                           const Subtitle &sub, int start, int end);
 
+  // Display a bar at the top of the subtitle if the live error checking has
+  // found an error.
+  void draw_subtitle_errors(const Cairo::RefPtr<Cairo::Context> &cr,
+                            const Subtitle &sub, int start, int end);
+
   // Draw subtitles visible
   void draw_subtitles(const Cairo::RefPtr<Cairo::Context> &cr,
                       const Gdk::Rectangle &area);
@@ -112,7 +134,18 @@ class WaveformRendererCairo : public Gtk::DrawingArea, public WaveformRenderer {
 
  protected:
   Cairo::RefPtr<Cairo::Surface> m_wf_surface;
+  Cairo::RefPtr<Cairo::Surface> m_timeline_surface;
+  Cairo::RefPtr<Cairo::Surface> m_keyframes_surface;
+  Cairo::RefPtr<Cairo::Surface> m_subtitles_surface;
   Glib::RefPtr<Pango::Layout> m_layout_text;
+
+  // The view of the cached layers
+  int m_layers_start_area{0};
+  int m_layers_zoom{0};
+  float m_layers_scale{0};
+
+  // The position (x) of the player drawn
+  int m_player_position{-1};
 };
 
 WaveformRendererCairo::WaveformRendererCairo() : WaveformRenderer() {
@@ -143,21 +176,23 @@ void WaveformRendererCairo::set_color(const Cairo::RefPtr<Cairo::Context> &cr,
 void WaveformRendererCairo::waveform_changed() {
   se_dbg(SE_DBG_WAVEFORM);
 
-  if (m_wf_surface)
-    m_wf_surface.clear();
+  clear_layers();
   queue_draw();
 }
 
 void WaveformRendererCairo::keyframes_changed() {
   se_dbg(SE_DBG_WAVEFORM);
 
+  m_keyframes_surface.clear();
   queue_draw();
 }
 
 // Call queue_draw
+// The subtitles (document) may have changed, the layer is drawn again.
 void WaveformRendererCairo::redraw_all() {
   se_dbg(SE_DBG_WAVEFORM);
 
+  m_subtitles_surface.clear();
   queue_draw();
 }
 
@@ -165,16 +200,28 @@ void WaveformRendererCairo::redraw_all() {
 void WaveformRendererCairo::force_redraw_all() {
   se_dbg(SE_DBG_WAVEFORM);
 
-  if (m_wf_surface)
-    m_wf_surface.clear();
+  clear_layers();
   queue_draw();
 }
 
+// The layers are still valid, only the strips of the old and the new
+// position are painted again.
+void WaveformRendererCairo::player_position_changed() {
+  int pos = get_pos_by_time(player_time()) - get_start_area();
+  if (pos == m_player_position)
+    return;
+
+  // The line is 2 pixels wide (cairo default)
+  int height = get_height() - 30;
+  if (m_player_position >= 0)
+    queue_draw_area(m_player_position - 2, 30, 5, height);
+  queue_draw_area(pos - 2, 30, 5, height);
+}
+
 bool WaveformRendererCairo::on_configure_event(GdkEventConfigure * /*ev*/) {
   se_dbg(SE_DBG_WAVEFORM);
 
-  if (m_wf_surface)
-    m_wf_surface.clear();
+  clear_layers();
   queue_draw();
 
   // return false IMPORTANT!!!
@@ -206,55 +253,64 @@ bool WaveformRendererCairo::on_draw(const Cairo::RefPtr<Cairo::Context> &cr) {
   if (m_waveform) {
     Gdk::Rectangle warea(0, 0, get_width(), get_height() - 30);
 
-    // check
-    {
-      static int old_start_area = get_start_area();
-      static double old_zoom = zoom();
-      static double old_scale = scale();
-
-      if (old_zoom != zoom() || old_scale != scale() ||
-          old_start_area != get_start_area()) {
-        m_wf_surface.clear();
-        old_start_area = get_start_area();
-        old_zoom = zoom();
-        old_scale = scale();
-      }
+    // The layers follow the view, they are invalid when it changes
+    if (m_layers_zoom != zoom() || m_layers_scale != scale() ||
+        m_layers_start_area != get_start_area()) {
+      clear_layers();
+      m_layers_start_area = get_start_area();
+      m_layers_zoom = zoom();
+      m_layers_scale = scale();
     }
 
     if (!m_wf_surface) {
-      m_wf_surface =
-          Cairo::Surface::create(cr->get_target(), Cairo::CONTENT_COLOR_ALPHA,
-                                 get_width(), get_height());
+      m_wf_surface = create_layer(cr, get_width(), get_height());
+      draw_waveform(Cairo::Context::create(m_wf_surface), warea);
+    }
 
-      Cairo::RefPtr<Cairo::Context> wf_cr =
-          Cairo::Context::create(m_wf_surface);
+    if (!m_keyframes_surface) {
+      m_keyframes_surface =
+          create_layer(cr, warea.get_width(), warea.get_height());
+      Cairo::RefPtr<Cairo::Context> kf_cr =
+          Cairo::Context::create(m_keyframes_surface);
+      kf_cr->translate(-get_start_area(), 0);
+      draw_keyframes(kf_cr, warea);
+    }
 
-      draw_waveform(wf_cr, warea);
+    if (!m_subtitles_surface) {
+      m_subtitles_surface =
+          create_layer(cr, warea.get_width(), warea.get_height());
+      if (document()) {
+        Cairo::RefPtr<Cairo::Context> sub_cr =
+            Cairo::Context::create(m_subtitles_surface);
+        sub_cr->translate(-get_start_area(), 0);
+        draw_subtitles(sub_cr, warea);
+      }
     }
 
-    if (m_wf_surface) {
-      cr->save();
-      cr->translate(0, 30);
-      cr->set_source(m_wf_surface, 0, 0);
-      cr->paint();
-      cr->restore();
+    if (!m_timeline_surface) {
+      // The bottom line (y=30) overflows the area by a pixel
+      m_timeline_surface = create_layer(cr, get_width(), 32);
+      draw_timeline(Cairo::Context::create(m_timeline_surface),
+                    Gdk::Rectangle(0, 0, get_width(), 30));
     }
 
+    paint_layer(cr, m_wf_surface, 0, 30);
+    paint_layer(cr, m_keyframes_surface, 0, 30);
+    paint_layer(cr, m_subtitles_surface, 0, 30);
+
     cr->save();
     cr->translate(-get_start_area(), 30);
 
-    draw_keyframes(cr, warea);
-
-    if (document()) {
-      draw_subtitles(cr, warea);
+    if (document())
       draw_marker(cr, warea);
-    }
 
     draw_player_position(cr, warea);
 
     cr->restore();
 
-    draw_timeline(cr, Gdk::Rectangle(0, 0, get_width(), 30));
+    m_player_position = get_pos_by_time(player_time()) - get_start_area();
+
+    paint_layer(cr, m_timeline_surface, 0, 0);
 
     if (m_display_time_info)
       display_time_info(cr, warea);
@@ -275,6 +331,28 @@ bool WaveformRendererCairo::on_draw(const Cairo::RefPtr<Cairo::Context> &cr) {
   return true;
 }
 
+void WaveformRendererCairo::clear_layers() {
+  m_wf_surface.clear();
+  m_timeline_surface.clear();
+  m_keyframes_surface.clear();
+  m_subtitles_surface.clear();
+}
+
+Cairo::RefPtr<Cairo::Surface> WaveformRendererCairo::create_layer(
+    const Cairo::RefPtr<Cairo::Context> &cr, int width, int height) {
+  return Cairo::Surface::create(cr->get_target(), Cairo::CONTENT_COLOR_ALPHA,
+                                width, height);
+}
+
+void WaveformRendererCairo::paint_layer(
+    const Cairo::RefPtr<Cairo::Context> &cr,
+    const Cairo::RefPtr<Cairo::Surface> &layer, int x, int y) {
+  cr->save();
+  cr->set_source(layer, x, y);
+  cr->paint();
+  cr->restore();
+}
+
 // Display all of timeline: Time, seconds
 void WaveformRendererCairo::draw_timeline(
     const Cairo::RefPtr<Cairo::Context> &cr, const Gdk::Rectangle &area) {
@@ -408,8 +486,6 @@ void WaveformRendererCairo::draw_channel(
   if (!m_waveform)
     return;
 
-  std::vector<double> &peaks = m_waveform->m_channels[channel];
-
   set_color(cr, m_color_wave);
 
   int bottom = area.get_height();
@@ -420,28 +496,36 @@ void WaveformRendererCairo::draw_channel(
 
   se_dbg_msg(SE_DBG_WAVEFORM, "init drawing values");
 
-  int skip = 4;
+  int skip = 2;
   int z = zoom();
 
+  guint64 peaks_size = m_waveform->get_size();
   double begin =
-      peaks.size() * (static_cast<double>(get_start_area()) / (width * z));
-  double move = peaks.size() * (static_cast<double>(skip) / (width * z));
+      peaks_size * (static_cast<double>(get_start_area()) / (width * z));
+  double move = peaks_size * (static_cast<double>(skip) / (width * z));
   int length = width;
-  int peaks_size = peaks.size();
 
   double x = begin;
 
   se_dbg_msg(SE_DBG_WAVEFORM, "begin %f  move %f  length %d  peaks_size %d",
-             begin, move, length, peaks_size);
+             begin, move, length, static_cast<int>(peaks_size));
 
   se_dbg_msg(SE_DBG_WAVEFORM, "start drawing peaks");
 
+  // Each step covers the samples [x, x + move), the waveform returns their max
+  // from the pyramid level matching the zoom. The cost depends on the number
+  // of pixels and no peak is skipped.
+  double min, max;
   cr->line_to(0, bottom);
   for (int t = 0; t < length; t += skip, x += move) {
-    int px = static_cast<int>(x);
-    if (px > peaks_size)
+    guint64 first = static_cast<guint64>(x);
+    if (first >= peaks_size)
       break;
-    double peakOnScreen = peaks[px] * scale_value;
+    guint64 last = std::max(static_cast<guint64>(x + move), first + 1);
+
+    m_waveform->get_peak(channel, first, last, min, max);
+
+    double peakOnScreen = max * scale_value;
 
     peakOnScreen = CLAMP(peakOnScreen, 0, bottom);
 
@@ -484,6 +568,19 @@ void WaveformRendererCairo::draw_subtitle_text(
   cr->restore();
 }
 
+// Display a bar at the top of the subtitle if the live error checking has
+// found an error.
+void WaveformRendererCairo::draw_subtitle_errors(
+    const Cairo::RefPtr<Cairo::Context> &cr, const Subtitle &sub, int start,
+    int end) {
+  if (sub.get_errors() == 0)
+    return;
+
+  set_color(cr, m_color_subtitle_invalid);
+  cr->rectangle(start, 0, end - start, 3);
+  cr->fill();
+}
+
 // Draw subtitles visible
 void WaveformRendererCairo::draw_subtitles(
     const Cairo::RefPtr<Cairo::Context> &cr, const Gdk::Rectangle &area) {
@@ -500,57 +597,28 @@ void WaveformRendererCairo::draw_subtitles(
   Subtitles subs = document()->subtitles();
   Subtitle selected = subs.get_first_selected();
 
-  if (selected) {
-    for (Subtitle sub = subs.get_first(); sub; ++sub) {
-      SubtitleTime start = sub.get_start();
-      SubtitleTime end = sub.get_end();
-
-      if (start < start_clip && end < start_clip)
-        continue;
-      if (start > end_clip && end > end_clip)
-        break;
-
-      int s = get_pos_by_time(start.totalmsecs);
-      int e = get_pos_by_time(end.totalmsecs);
-
-      if (s > e) {
-        set_color(cr, m_color_subtitle_invalid);
-      } else if (selected == sub) {
-        set_color(cr, m_color_subtitle_selected);
-      } else {
-        set_color(cr, m_color_subtitle);
-      }
+  // Only the subtitles in the visible area, found with the time index
+  std::vector<Subtitle> visible = subs.find_range(start_clip, end_clip);
 
-      cr->rectangle(s, 0, e - s, h);
-      cr->fill();
+  for (const auto &sub : visible) {
+    int s = get_pos_by_time(sub.get_start().totalmsecs);
+    int e = get_pos_by_time(sub.get_end().totalmsecs);
 
-      if (m_display_subtitle_text)
-        draw_subtitle_text(cr, sub, s, e);
+    if (s > e) {
+      set_color(cr, m_color_subtitle_invalid);
+    } else if (selected && selected == sub) {
+      set_color(cr, m_color_subtitle_selected);
+    } else {
+      set_color(cr, m_color_subtitle);
     }
-  } else {
-    for (Subtitle sub = subs.get_first(); sub; ++sub) {
-      SubtitleTime start = sub.get_start();
-      SubtitleTime end = sub.get_end();
-
-      if (start < start_clip && end < start_clip)
-        continue;
-      if (start > end_clip && end > end_clip)
-        break;
 
-      int s = get_pos_by_time(start.totalmsecs);
-      int e = get_pos_by_time(end.totalmsecs);
+    cr->rectangle(s, 0, e - s, h);
+    cr->fill();
 
-      if (s > e)
-        set_color(cr, m_color_subtitle_invalid);
-      else
-        set_color(cr, m_color_subtitle);
+    draw_subtitle_errors(cr, sub, s, e);
 
-      cr->rectangle(s, 0, e - s, h);
-      cr->fill();
-
-      if (m_display_subtitle_text)
-        draw_subtitle_text(cr, sub, s, e);
-    }
+    if (m_display_subtitle_text)
+      draw_subtitle_text(cr, sub, s, e);
   }
 }
 
@@ -685,10 +753,10 @@ void WaveformRendererCairo::draw_keyframes(
   long start_clip = get_time_by_pos(get_start_area());
   long end_clip = get_time_by_pos(get_end_area());
 
-  for (auto it = keyframes->begin(); it != keyframes->end(); ++it) {
-    // display only if it's in the area
-    if (*it < start_clip && *it < end_clip)
-      continue;
+  // The keyframes are sorted, start from the first one in the area
+  for (auto it = std::lower_bound(keyframes->begin(), keyframes->end(),
+                                  start_clip);
+       it != keyframes->end(); ++it) {
     if (*it > end_clip)
       break;  // the next keyframes are out of the area
 
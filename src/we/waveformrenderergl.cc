@@ -22,6 +22,7 @@
 
 #include <GL/gl.h>
 #include <gtkglmm.h>
+#include <algorithm>
 
 #include "document.h"
 #include "keyframes.h"
@@ -84,10 +85,12 @@ class WaveformRendererGL : public Gtk::GL::DrawingArea,
   void draw_subtitles_text(const Gdk::Rectangle &rect);
 
   // Draw the channel in the area with the lines methods
-  void draw_channel_with_line_strip(const Gdk::Rectangle &area, int channel);
+  void draw_channel_with_line_strip(const Gdk::Rectangle &area, int channel,
+                                    guint level);
 
   // Draw the channel in the area with the quad methods
-  void draw_channel_with_quad_strip(const Gdk::Rectangle &area, int channel);
+  void draw_channel_with_quad_strip(const Gdk::Rectangle &area, int channel,
+                                    guint level);
 
   // Display all of timeline: Time, seconds
   void draw_timeline(const Gdk::Rectangle &area);
@@ -138,6 +141,8 @@ class WaveformRendererGL : public Gtk::GL::DrawingArea,
   Gdk::Rectangle m_displayListRect;
   GLuint m_displayList;
   GLsizei m_displayListSize;
+  // The level of the waveform pyramid used by the display list
+  guint m_displayListLevel;
 };
 
 // Constructor
@@ -146,7 +151,8 @@ WaveformRendererGL::WaveformRendererGL()
       m_fontListBase(0),
       m_fontHeight(0),
       m_displayList(0),
-      m_displayListSize(0) {
+      m_displayListSize(0),
+      m_displayListLevel(0) {
   Glib::RefPtr<Gdk::GL::Config> glconfig = create_glconfig();
   if (glconfig)
     set_gl_capability(glconfig);
@@ -427,13 +433,13 @@ void WaveformRendererGL::draw(GdkEventExpose *ev) {
 
 // Draw the channel in the area with the lines methods
 void WaveformRendererGL::draw_channel_with_line_strip(
-    const Gdk::Rectangle &area, int channel) {
+    const Gdk::Rectangle &area, int channel, guint level) {
   if (!m_waveform)
     return;
 
-  std::vector<double> &peaks = m_waveform->m_channels[channel];
+  guint64 size = m_waveform->get_level_size(level);
 
-  float skip = static_cast<float>(area.get_width()) / peaks.size();
+  float skip = static_cast<float>(area.get_width()) / size;
 
   float px = 0;
 
@@ -441,30 +447,35 @@ void WaveformRendererGL::draw_channel_with_line_strip(
 
   glBegin(GL_LINE_STRIP);
 
-  for (const auto it = peaks.begin(); it != peaks.end(); ++it, px += skip)
-    glVertex2d(px, *it);
+  double min, max;
+  for (guint64 i = 0; i < size; ++i, px += skip) {
+    m_waveform->get_level_peak(channel, level, i, min, max);
+    glVertex2d(px, max);
+  }
 
   glEnd();
 }
 
 // Draw the channel in the area with the lines methods
 void WaveformRendererGL::draw_channel_with_quad_strip(
-    const Gdk::Rectangle &area, int channel) {
+    const Gdk::Rectangle &area, int channel, guint level) {
   if (!m_waveform)
     return;
 
-  std::vector<double> &peaks = m_waveform->m_channels[channel];
+  guint64 size = m_waveform->get_level_size(level);
 
-  float skip = static_cast<float>(area.get_width()) / peaks.size();
+  float skip = static_cast<float>(area.get_width()) / size;
 
   float px = 0;
 
   glColor4fv(m_color_wave);
 
   glBegin(GL_QUAD_STRIP);
-  for (const auto it it = peaks.begin(); it != peaks.end(); ++it, px += skip) {
+  double min, max;
+  for (guint64 i = 0; i < size; ++i, px += skip) {
+    m_waveform->get_level_peak(channel, level, i, min, max);
     glVertex2d(px, 0);
-    glVertex2d(px, *it);
+    glVertex2d(px, max);
   }
   glEnd();
 }
@@ -479,7 +490,8 @@ void WaveformRendererGL::delete_display_lists() {
 }
 
 // The Waveform used a display list for optimize the render.
-// If the OpenGL display list (waveform) is not yet create:
+// If the OpenGL display list (waveform) is not yet create or if the zoom need
+// an other level of the waveform pyramid:
 // - Create the display list and draw the waveform inside.
 // Call the display list for drawing the waveform.
 void WaveformRendererGL::draw_waveform(const Gdk::Rectangle &rect) {
@@ -490,7 +502,16 @@ void WaveformRendererGL::draw_waveform(const Gdk::Rectangle &rect) {
 
   int h = rect.get_height() / n_channels;
 
+  // Only one vertex by pixel is needed
+  double samples_per_pixel = static_cast<double>(m_waveform->get_size()) /
+                             (rect.get_width() * zoom());
+  guint level = m_waveform->get_level_for_samples_per_pixel(samples_per_pixel);
+  if (level != m_displayListLevel)
+    delete_display_lists();
+
   if (m_displayListSize == 0) {
+    m_displayListLevel = level;
+
     // display to rectangle 10x10
     // after is scale to the widget area (size + zoom)
     Gdk::Rectangle area(0, 0, 10, 10);
@@ -502,8 +523,8 @@ void WaveformRendererGL::draw_waveform(const Gdk::Rectangle &rect) {
     for (unsigned int i = 0; i < n_channels; ++i) {
       glNewList(m_displayList + i, GL_COMPILE);
 
-      draw_channel_with_quad_strip(area, i);
-      draw_channel_with_line_strip(area, i);
+      draw_channel_with_quad_strip(area, i, level);
+      draw_channel_with_line_strip(area, i, level);
 
       glEndList();
     }
@@ -674,11 +695,10 @@ void WaveformRendererGL::draw_keyframes(const Gdk::Rectangle &rect) {
   long end_clip = get_time_by_pos(get_end_area());
 
   glBegin(GL_LINES);
-  for (KeyFrames::const_iterator it = keyframes->begin();
+  // The keyframes are sorted, start from the first one in the area
+  for (KeyFrames::const_iterator it = std::lower_bound(
+           keyframes->begin(), keyframes->end(), start_clip);
        it != keyframes->end(); ++it) {
-    // display only if it's in the area
-    if (*it < start_clip && *it < end_clip)
-      continue;
     if (*it > end_clip)
       break;  // the next keyframes are out of the area
 
@@ -755,48 +775,21 @@ void WaveformRendererGL::draw_subtitles(const Gdk::Rectangle &rect) {
   glPushMatrix();
   glTranslatef(-get_start_area(), 0, 0);
 
-  if (selected) {
-    for (Subtitle sub = subs.get_first(); sub; ++sub) {
-      SubtitleTime start = sub.get_start();
-      SubtitleTime end = sub.get_end();
-
-      if (start < start_clip && end < start_clip)
-        continue;
-      if (start > end_clip && end > end_clip)
-        break;
-
-      int s = get_pos_by_time(start.totalmsecs);
-      int e = get_pos_by_time(end.totalmsecs);
-
-      if (s > e)
-        glColor4fv(m_color_subtitle_invalid);
-      else if (selected == sub)
-        glColor4fv(m_color_subtitle_selected);
-      else
-        glColor4fv(m_color_subtitle);
-
-      glRectf(s, 0, e, height);
-    }
-  } else {
-    for (Subtitle sub = subs.get_first(); sub; ++sub) {
-      SubtitleTime start = sub.get_start();
-      SubtitleTime end = sub.get_end();
-
-      if (start < start_clip && end < start_clip)
-        continue;
-      if (start > end_clip && end > end_clip)
-        break;
+  // Only the subtitles in the visible area, found with the time index
+  std::vector<Subtitle> visible = subs.find_range(start_clip, end_clip);
 
-      int s = get_pos_by_time(start.totalmsecs);
-      int e = get_pos_by_time(end.totalmsecs);
+  for (const auto &sub : visible) {
+    int s = get_pos_by_time(sub.get_start().totalmsecs);
+    int e = get_pos_by_time(sub.get_end().totalmsecs);
 
-      if (s > e)
-        glColor4fv(m_color_subtitle_invalid);
-      else
-        glColor4fv(m_color_subtitle);
+    if (s > e)
+      glColor4fv(m_color_subtitle_invalid);
+    else if (selected && selected == sub)
+      glColor4fv(m_color_subtitle_selected);
+    else
+      glColor4fv(m_color_subtitle);
 
-      glRectf(s, 0, e, height);
-    }
+    glRectf(s, 0, e, height);
   }
   glPopMatrix();
 }
@@ -812,7 +805,6 @@ void WaveformRendererGL::draw_subtitles_text(const Gdk::Rectangle &rect) {
   float height = rect.get_height() - m_fontHeight * 2;
 
   Subtitles subs = document()->subtitles();
-  Subtitle selected = subs.get_first_selected();
 
   glPushMatrix();
   glTranslatef(-get_start_area(), 0, 0);
@@ -820,16 +812,10 @@ void WaveformRendererGL::draw_subtitles_text(const Gdk::Rectangle &rect) {
   glColor4fv(m_color_text);
   glListBase(m_fontListBase);
 
-  for (Subtitle sub = subs.get_first(); sub; ++sub) {
-    SubtitleTime start = sub.get_start();
-    SubtitleTime end = sub.get_end();
-
-    if (start < start_clip && end < start_clip)
-      continue;
-    if (start > end_clip && end > end_clip)
-      break;
+  std::vector<Subtitle> visible = subs.find_range(start_clip, end_clip);
 
-    int s = get_pos_by_time(start.totalmsecs);
+  for (const auto &sub : visible) {
+    int s = get_pos_by_time(sub.get_start().totalmsecs);
     // int e = get_pos_by_time(end.totalmsecs);
 
     glRasterPos2f(s, height);